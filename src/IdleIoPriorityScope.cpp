@@ -0,0 +1,31 @@
+#include "IdleIoPriorityScope.h"
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// ioprio_set(2) has no glibc wrapper; values from linux/ioprio.h.
+constexpr int IoprioWhoProcess = 1;
+constexpr int IoprioClassShift = 13;
+constexpr int IoprioClassIdle = 3;
+#endif
+
+}
+
+IdleIoPriorityScope::IdleIoPriorityScope() {
+#ifdef Q_OS_LINUX
+    m_io = syscall(SYS_ioprio_get, IoprioWhoProcess, 0);
+    syscall(SYS_ioprio_set, IoprioWhoProcess, 0, IoprioClassIdle << IoprioClassShift);
+#endif
+}
+
+IdleIoPriorityScope::~IdleIoPriorityScope() {
+#ifdef Q_OS_LINUX
+    if (m_io >= 0) syscall(SYS_ioprio_set, IoprioWhoProcess, 0, m_io);
+#endif
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Lowers the calling thread to idle I/O priority for its lifetime and
+// restores it afterwards. CPU priority is not touched: an unprivileged
+// thread that enters SCHED_IDLE cannot leave it, so idle CPU priority
+// belongs to pools whose threads only ever run background work
+// (QThreadPool::setThreadPriority(QThread::IdlePriority)).
+class IdleIoPriorityScope {
+public:
+    IdleIoPriorityScope();
+    ~IdleIoPriorityScope();
+    IdleIoPriorityScope(const IdleIoPriorityScope &) = delete;
+    IdleIoPriorityScope &operator=(const IdleIoPriorityScope &) = delete;
+
+private:
+    long m_io = -1;
+};
@@ -0,0 +1,285 @@
+#include "ImageDecoder.h"
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSet>
+#include <QTransform>
+#include <QVector>
+#include <cstring>
+
+namespace {
+
+struct EmbeddedPreview {
+    qint64 offset = 0;
+    qint64 length = 0;
+};
+
+// Minimal TIFF structure walker, enough to find JPEG previews and the
+// orientation tag in EXIF blocks and TIFF-based RAW files.
+class TiffReader {
+public:
+    TiffReader(const uchar *data, qint64 size, qint64 base) : m_data(data), m_size(size), m_base(base) {}
+
+    bool open() {
+        if (!contains(m_base, 8)) return false;
+        if (m_data[m_base] == 'I' && m_data[m_base + 1] == 'I') m_bigEndian = false;
+        else if (m_data[m_base] == 'M' && m_data[m_base + 1] == 'M') m_bigEndian = true;
+        else return false;
+        // Plain TIFF, or Panasonic RW2's variant of the header.
+        const quint16 magic = u16(m_base + 2);
+        return magic == 42 || magic == 0x55;
+    }
+
+    void scan(QVector<EmbeddedPreview> &previews, int &orientation) {
+        QSet<qint64> seen;
+        scanIfd(u32(m_base + 4), 0, previews, orientation, seen);
+    }
+
+private:
+    bool contains(qint64 offset, qint64 length) const {
+        return offset >= 0 && length >= 0 && offset + length <= m_size;
+    }
+    quint16 u16(qint64 offset) const {
+        if (!contains(offset, 2)) return 0;
+        const uchar *p = m_data + offset;
+        return m_bigEndian ? quint16(p[0] << 8 | p[1]) : quint16(p[1] << 8 | p[0]);
+    }
+    quint32 u32(qint64 offset) const {
+        if (!contains(offset, 4)) return 0;
+        const uchar *p = m_data + offset;
+        return m_bigEndian ? quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | p[3]
+                           : quint32(p[3]) << 24 | quint32(p[2]) << 16 | quint32(p[1]) << 8 | p[0];
+    }
+    // Value of a single SHORT or LONG entry stored inline.
+    quint32 value(qint64 entry) const {
+        return u16(entry + 2) == 3 ? u16(entry + 8) : u32(entry + 8);
+    }
+
+    void scanIfd(quint32 ifd, int depth, QVector<EmbeddedPreview> &previews, int &orientation, QSet<qint64> &seen) {
+        // Offsets are relative to the TIFF header; bound the walk against loops.
+        while (ifd && depth < 4 && !seen.contains(ifd) && contains(m_base + ifd, 2)) {
+            seen.insert(ifd);
+            const qint64 start = m_base + ifd;
+            const int count = u16(start);
+            quint32 jpegOffset = 0, jpegLength = 0, stripOffset = 0, stripLength = 0, compression = 0;
+            for (int i = 0; i < count; ++i) {
+                const qint64 entry = start + 2 + qint64(i) * 12;
+                if (!contains(entry, 12)) return;
+                const quint32 entryCount = u32(entry + 4);
+                switch (u16(entry)) {
+                case 0x0103: compression = value(entry); break;
+                case 0x0111: if (entryCount == 1) stripOffset = value(entry); break;
+                case 0x0117: if (entryCount == 1) stripLength = value(entry); break;
+                case 0x0112: if (depth == 0 && !orientation) orientation = value(entry); break;
+                case 0x0201: jpegOffset = value(entry); break;
+                case 0x0202: jpegLength = value(entry); break;
+                case 0x002E:  // RW2 JpgFromRaw: the preview as an UNDEFINED blob
+                    if (depth == 0) addPreview(previews, u32(entry + 8), entryCount);
+                    break;
+                case 0x014A: {  // SubIFDs: where RAW files keep their full-size previews
+                    if (entryCount == 1) {
+                        scanIfd(u32(entry + 8), depth + 1, previews, orientation, seen);
+                    } else {
+                        const quint32 list = u32(entry + 8);
+                        for (quint32 n = 0; n < entryCount && n < 8; ++n) {
+                            scanIfd(u32(m_base + list + n * 4), depth + 1, previews, orientation, seen);
+                        }
+                    }
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+            if (jpegOffset && jpegLength) addPreview(previews, jpegOffset, jpegLength);
+            else if ((compression == 6 || compression == 7) && stripOffset && stripLength) addPreview(previews, stripOffset, stripLength);
+            ifd = u32(start + 2 + qint64(count) * 12);
+        }
+    }
+
+    void addPreview(QVector<EmbeddedPreview> &previews, quint32 offset, quint32 length) const {
+        const qint64 at = m_base + offset;
+        // Only baseline JPEG streams (SOI marker) are worth handing to Qt.
+        if (contains(at, length) && length > 2 && m_data[at] == 0xFF && m_data[at + 1] == 0xD8) {
+            previews.append({at, length});
+        }
+    }
+
+    const uchar *m_data;
+    qint64 m_size;
+    qint64 m_base;
+    bool m_bigEndian = false;
+};
+
+// Offset of the TIFF header inside a JPEG's Exif APP1 segment, or -1.
+qint64 exifTiffOffset(const uchar *data, qint64 size) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return -1;
+    qint64 pos = 2;
+    while (pos + 4 <= size && data[pos] == 0xFF) {
+        const uchar marker = data[pos + 1];
+        const qint64 length = qint64(data[pos + 2]) << 8 | data[pos + 3];
+        if (marker == 0xDA || length < 2) break;  // start of scan: no more metadata
+        if (marker == 0xE1 && pos + 10 <= size && memcmp(data + pos + 4, "Exif\0\0", 6) == 0) {
+            return pos + 10;
+        }
+        pos += 2 + length;
+    }
+    return -1;
+}
+
+// Size of a JPEG's main image from its SOF marker, or an invalid size.
+QSize jpegFrameSize(const uchar *data, qint64 size) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return QSize();
+    qint64 pos = 2;
+    while (pos + 9 <= size && data[pos] == 0xFF) {
+        const uchar marker = data[pos + 1];
+        const qint64 length = qint64(data[pos + 2]) << 8 | data[pos + 3];
+        if (marker == 0xDA || length < 2) break;
+        // SOF0..SOF15, minus DHT, JPG and DAC which share the range.
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            const int height = data[pos + 5] << 8 | data[pos + 6];
+            const int width = data[pos + 7] << 8 | data[pos + 8];
+            return QSize(width, height);
+        }
+        pos += 2 + length;
+    }
+    return QSize();
+}
+
+// Whether a preview shows the whole frame: cameras letterbox small EXIF
+// thumbnails of 3:2 and 16:9 shots, and editors leave them stale after a crop.
+bool sameAspect(const QSize &preview, const QSize &main) {
+    if (!main.isValid() || main.isEmpty()) return true;
+    const qreal previewRatio = qreal(preview.width()) / preview.height();
+    const qreal mainRatio = qreal(main.width()) / main.height();
+    return qAbs(previewRatio - mainRatio) <= mainRatio * 0.02;
+}
+
+QImage applyOrientation(const QImage &image, int orientation) {
+    switch (orientation) {
+    case 2: return image.mirrored(true, false);
+    case 3: return image.mirrored(true, true);
+    case 4: return image.mirrored(false, true);
+    case 5: return image.transformed(QTransform().rotate(90)).mirrored(true, false);
+    case 6: return image.transformed(QTransform().rotate(90));
+    case 7: return image.transformed(QTransform().rotate(90)).mirrored(false, true);
+    case 8: return image.transformed(QTransform().rotate(270));
+    default: return image;
+    }
+}
+
+bool covers(const QSize &size, const QSize &bound) {
+    return size.width() >= bound.width() || size.height() >= bound.height();
+}
+
+bool swapsAxes(QImageIOHandler::Transformations transformation) {
+    return transformation & QImageIOHandler::TransformationRotate90;
+}
+
+// Smallest embedded preview that covers bound (the largest one for RAW
+// files, whose main image Qt usually cannot decode), decoded and scaled.
+QImage decodeEmbedded(const uchar *data, qint64 size, bool raw, const QSize &bound) {
+    qint64 tiffOffset = raw ? 0 : exifTiffOffset(data, size);
+    QVector<EmbeddedPreview> previews;
+    int orientation = 0;
+    if (raw && size >= 92 && memcmp(data, "FUJIFILMCCD-RAW", 15) == 0) {
+        // RAF keeps its preview JPEG at a fixed header slot.
+        const auto be32 = [data](qint64 at) {
+            return quint32(data[at]) << 24 | quint32(data[at + 1]) << 16 | quint32(data[at + 2]) << 8 | data[at + 3];
+        };
+        const quint32 offset = be32(84), length = be32(88);
+        if (qint64(offset) + length <= size) previews.append({offset, length});
+        tiffOffset = -1;
+    }
+    if (tiffOffset >= 0) {
+        TiffReader tiff(data, size, tiffOffset);
+        if (tiff.open()) tiff.scan(previews, orientation);
+    }
+
+    // RAW files keep their full-size previews, so only JPEG's are checked.
+    const QSize mainSize = raw ? QSize() : jpegFrameSize(data, size);
+    QSize bestSize;
+    QByteArray bestBytes;
+    for (const EmbeddedPreview &preview : std::as_const(previews)) {
+        QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data + preview.offset), preview.length);
+        QBuffer buffer(&bytes);
+        QImageReader reader(&buffer, "jpeg");
+        const QSize previewSize = reader.size();
+        if (!previewSize.isValid() || !sameAspect(previewSize, mainSize)) continue;
+        const bool better = bestSize.isEmpty()
+            || (covers(previewSize, bound) && (!covers(bestSize, bound) || previewSize.width() < bestSize.width()))
+            || (!covers(bestSize, bound) && previewSize.width() > bestSize.width());
+        if (better) {
+            bestSize = previewSize;
+            bestBytes = bytes;
+        }
+    }
+    if (bestSize.isEmpty() || (!raw && !covers(bestSize, bound))) return QImage();
+
+    QBuffer buffer(&bestBytes);
+    QImageReader reader(&buffer, "jpeg");
+    reader.setAutoTransform(true);
+    const bool ownTransform = reader.transformation() != QImageIOHandler::TransformationNone;
+    const QSize target = swapsAxes(reader.transformation()) ? bound.transposed() : bound;
+    if (covers(bestSize, target)) reader.setScaledSize(bestSize.scaled(target, Qt::KeepAspectRatio));
+    QImage best = reader.read();
+    if (best.isNull()) return QImage();
+    // The container's orientation applies unless the preview carries its own.
+    if (!ownTransform) {
+        best = applyOrientation(best, orientation);
+        if (covers(best.size(), bound) && (best.width() > bound.width() || best.height() > bound.height())) {
+            best = best.scaled(bound, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+    }
+    return best;
+}
+
+}
+
+bool ImageDecoder::isRawFile(const QString &path) {
+    static const QSet<QString> rawSuffixes = {
+        "arw", "cr2", "dng", "nef", "nrw", "pef", "raf", "rw2", "sr2", "srf", "srw",
+    };
+    return rawSuffixes.contains(QFileInfo(path).suffix().toLower());
+}
+
+QImage ImageDecoder::decodeScaled(const QString &path, const QSize &bound, qint64 maxDecodeBytes, bool *embedded) {
+    if (embedded) *embedded = false;
+    if (bound.isEmpty()) return QImage();
+    const bool raw = isRawFile(path);
+
+    // Embedded previews first: they are a fraction of the file and often
+    // already close to the size we want.
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        const qint64 size = file.size();
+        if (const uchar *data = file.map(0, size)) {
+            const QImage preview = decodeEmbedded(data, size, raw, bound);
+            file.unmap(const_cast<uchar*>(data));
+            if (!preview.isNull()) {
+                if (embedded) *embedded = true;
+                return preview;
+            }
+        }
+    }
+
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    const QSize fullSize = reader.size();
+    if (!fullSize.isValid()) {
+        const QImage image = reader.read();
+        if (image.isNull()) return QImage();
+        return covers(image.size(), bound) ? image.scaled(bound, Qt::KeepAspectRatio, Qt::SmoothTransformation) : image;
+    }
+
+    const QSize target = swapsAxes(reader.transformation()) ? bound.transposed() : bound;
+    const bool downscale = fullSize.width() > target.width() || fullSize.height() > target.height();
+    // Readers without native scaling decode every pixel before scaling.
+    const bool nativeScaling = reader.supportsOption(QImageIOHandler::ScaledSize);
+    if (!(downscale && nativeScaling) && qint64(fullSize.width()) * fullSize.height() * 4 > maxDecodeBytes) {
+        return QImage();
+    }
+    if (downscale) reader.setScaledSize(fullSize.scaled(target, Qt::KeepAspectRatio));
+    return reader.read();
+}
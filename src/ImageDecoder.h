@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+// Decodes images straight to the size they will be shown at. Embedded
+// previews (EXIF thumbnails, the JPEG previews inside camera RAW files) are
+// used when they are big enough; otherwise the reader is asked for a scaled
+// decode, which JPEG serves with DCT scaling instead of decoding every pixel.
+// Thread-safe.
+class ImageDecoder {
+public:
+    // Refuse decodes that would need more than this many bytes of pixels.
+    static constexpr qint64 DefaultMaxDecodeBytes = 256ll * 1024 * 1024;
+
+    // Camera RAW formats whose embedded JPEG previews we can extract.
+    // Olympus ORF is left out: its previews sit inside the maker notes.
+    static bool isRawFile(const QString &path);
+
+    // Image fitting inside bound (aspect kept, EXIF orientation applied), or
+    // a null image if the file cannot be decoded within maxDecodeBytes.
+    // embedded is set when the image came from an embedded preview.
+    static QImage decodeScaled(const QString &path, const QSize &bound,
+                               qint64 maxDecodeBytes = DefaultMaxDecodeBytes,
+                               bool *embedded = nullptr);
+};
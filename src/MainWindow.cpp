@@ -3,12 +3,16 @@
 #include "DialogUtils.h"
 #include "Pane.h"
 #include "SettingsDialog.h"
+#include "ThumbCache.h"
+#include "ThumbnailMaintenance.h"
+#include "ThumbnailPrewarmer.h"
 
 // Qt Core
 #include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
 #include <QSettings>
+#include <QLocale>
 #include <QStorageInfo>
 #include <QTimer>
 #include <QUrl>
@@ -193,6 +197,18 @@ MainWindow::MainWindow(const QUrl &initialUrl, QWidget *parent) : QMainWindow(pa
         saveSettings();
     });
     
+    // Thumbnail cache housekeeping reports back through the status bar.
+    connect(ThumbnailMaintenance::instance(), &ThumbnailMaintenance::finished, this,
+            [this](const ThumbnailMaintenance::Report &report) {
+        if (report.reclaimedBytes <= 0) return;
+        statusBar()->showMessage(QString("Thumbnail cache: freed %1 (%2 stale, %3 old entries)")
+                                 .arg(QLocale().formattedDataSize(report.reclaimedBytes))
+                                 .arg(report.staleRemoved)
+                                 .arg(report.evicted), 8000);
+    });
+    ThumbnailMaintenance::instance()->schedule();
+    ThumbnailPrewarmer::instance()->scheduleStartup();
+
     addInitialTab(initialUrl.isValid() ? initialUrl : QUrl::fromLocalFile("/"));
 
     // Load saved settings
@@ -572,6 +588,9 @@ void MainWindow::loadSettings() {
     bool showExts = settings.value("view/showFileExtensions", true).toBool();
     int millerWidth = settings.value("view/millerColumnWidth", 200).toInt();
     bool followSymlinks = settings.value("advanced/followSymlinks", false).toBool();
+    const qint64 thumbCacheMB = settings.value("view/thumbnailCacheMB", ThumbCache::DefaultCapacityMB).toLongLong();
+    ThumbCache::instance()->setCapacity(thumbCacheMB * 1024 * 1024);
+    ThumbnailPrewarmer::instance()->setEnabled(showThumbs);
 
     for (Pane *p : allPanes()) {
         p->setShowHiddenFiles(showHidden);
@@ -0,0 +1,543 @@
+#include "MillerColumnModel.h"
+#include "FileOpsService.h"
+#include "MillerSortEngine.h"
+#include <QDir>
+#include <QFutureWatcher>
+#include <QIcon>
+#include <QMimeData>
+#include <QSet>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <KIO/CopyJob>
+#include <KIO/SimpleJob>
+#include <KJob>
+#include <algorithm>
+
+namespace {
+
+// Below this many rows sorting inline is cheaper than a round trip to a worker.
+constexpr int AsyncSortThreshold = 10000;
+
+bool searchKeyLess(const QString &leftFolded, const QString &leftName,
+                   const QString &rightFolded, const QString &rightName) {
+    const int cmp = QString::compare(leftFolded, rightFolded);
+    return cmp != 0 ? cmp < 0 : leftName < rightName;
+}
+
+}
+
+MillerColumnModel::MillerColumnModel(MillerDirectoryCache *cache, QObject *parent)
+    : QAbstractListModel(parent), m_cache(cache) {}
+
+MillerColumnModel::~MillerColumnModel() {
+    detach();
+}
+
+void MillerColumnModel::detach() {
+    if (m_dir) {
+        disconnect(m_dir, nullptr, this, nullptr);
+        if (m_cache) m_cache->release(m_dir);
+    }
+    m_dir = nullptr;
+}
+
+void MillerColumnModel::setDirectory(const QUrl &url) {
+    beginResetModel();
+    detach();
+    m_url = url;
+    m_rowIndexValid = false;
+    resetSearchIndex();
+    m_sortScheduled = false;
+    m_loadPending = false;
+    if (m_cache) m_dir = m_cache->acquire(url);
+    loadRows();
+    endResetModel();
+
+    if (!m_dir) return;
+    connect(m_dir, &MillerDirectory::entriesAdded, this, &MillerColumnModel::onEntriesAdded);
+    connect(m_dir, &MillerDirectory::entriesRemoved, this, &MillerColumnModel::onEntriesRemoved);
+    connect(m_dir, &MillerDirectory::entriesChanged, this, &MillerColumnModel::onEntriesChanged);
+    connect(m_dir, &MillerDirectory::entryRenamed, this, &MillerColumnModel::onEntryRenamed);
+    connect(m_dir, &MillerDirectory::completed, this, &MillerColumnModel::onCompleted);
+    m_loadPending = true;
+    finishLoadingIfReady();
+}
+
+void MillerColumnModel::loadRows() {
+    // Entries from the listing worker already carry their collation keys,
+    // so this sort is key comparisons only.
+    ++m_rowsRevision;
+    QVector<MillerEntry> rows;
+    if (m_dir) {
+        rows.reserve(m_dir->entries().size());
+        for (const MillerEntry &entry : m_dir->entries()) {
+            if (acceptsEntry(entry)) rows.append(entry);
+        }
+    }
+    if (rows.size() < AsyncSortThreshold) {
+        m_rows = MillerSortEngine::sort(std::move(rows), 0, m_sortColumn, m_sortOrder).rows;
+        m_sortedRows = m_rows.size();
+        return;
+    }
+    // Huge cached folders go through the worker like any other large sort;
+    // they show in listing order for the moment it takes.
+    m_rows = std::move(rows);
+    m_sortedRows = 0;
+    scheduleSort();
+}
+
+QUrl MillerColumnModel::directoryUrl() const {
+    return m_dir ? m_dir->url() : m_url;
+}
+
+bool MillerColumnModel::isLoaded() const {
+    return m_dir && m_dir->isComplete() && !m_loadPending;
+}
+
+void MillerColumnModel::setShowHiddenFiles(bool show) {
+    if (m_showHidden == show) return;
+    m_showHidden = show;
+    if (!m_dir) return;
+
+    beginResetModel();
+    m_rowIndexValid = false;
+    resetSearchIndex();
+    loadRows();
+    endResetModel();
+}
+
+QUrl MillerColumnModel::url(const QModelIndex &index) const {
+    if (!index.isValid() || index.row() >= m_rows.size()) return QUrl();
+    const MillerEntry &entry = m_rows.at(index.row());
+    return entry.url.isValid() ? entry.url : urlForName(entry.name);
+}
+
+QUrl MillerColumnModel::urlForName(const QString &name) const {
+    const QUrl dirUrl = directoryUrl();
+    if (dirUrl.isLocalFile()) {
+        return QUrl::fromLocalFile(QDir(dirUrl.toLocalFile()).filePath(name));
+    }
+    QUrl result = dirUrl;
+    result.setPath(QDir::cleanPath(dirUrl.path() + QLatin1Char('/') + name), QUrl::DecodedMode);
+    return result;
+}
+
+QString MillerColumnModel::filePath(const QModelIndex &index) const {
+    return url(index).toLocalFile();
+}
+
+QString MillerColumnModel::fileName(const QModelIndex &index) const {
+    if (!index.isValid() || index.row() >= m_rows.size()) return QString();
+    return m_rows.at(index.row()).name;
+}
+
+bool MillerColumnModel::isDir(const QModelIndex &index) const {
+    return index.isValid() && index.row() < m_rows.size() && m_rows.at(index.row()).isDir;
+}
+
+bool MillerColumnModel::isSymLink(const QModelIndex &index) const {
+    return index.isValid() && index.row() < m_rows.size() && m_rows.at(index.row()).isSymLink;
+}
+
+QModelIndex MillerColumnModel::indexForName(const QString &name) const {
+    const int row = rowForName(name);
+    return row >= 0 ? index(row, 0) : QModelIndex();
+}
+
+QModelIndex MillerColumnModel::findName(const QString &text) const {
+    if (text.isEmpty() || m_rows.isEmpty()) return QModelIndex();
+    ensureSearchIndex();
+    const QString folded = text.toCaseFolded();
+
+    // Prefix matches form one contiguous run of the sorted keys.
+    const auto first = std::lower_bound(m_searchKeys.cbegin(), m_searchKeys.cend(), folded,
+        [](const SearchKey &key, const QString &value) { return key.folded < value; });
+    const auto last = std::partition_point(first, m_searchKeys.cend(),
+        [&folded](const SearchKey &key) { return key.folded.startsWith(folded); });
+    int best = -1;
+    for (auto it = first; it != last; ++it) {
+        if (it->row >= 0 && (best < 0 || it->row < best)) best = it->row;
+    }
+    if (best >= 0) return index(best, 0);
+
+    // The buffer is in row order, so its first hit is the first matching row.
+    const qsizetype pos = m_searchBuffer.indexOf(folded);
+    if (pos < 0) return QModelIndex();
+    const auto rowIt = std::upper_bound(m_searchOffsets.cbegin(), m_searchOffsets.cend(), int(pos));
+    return index(int(rowIt - m_searchOffsets.cbegin()) - 1, 0);
+}
+
+int MillerColumnModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant MillerColumnModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_rows.size()) return QVariant();
+    const MillerEntry &entry = m_rows.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return entry.name;
+    case Qt::DecorationRole:
+        return m_cache ? m_cache->iconForEntry(entry) : QIcon();
+    default:
+        return QVariant();
+    }
+}
+
+bool MillerColumnModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    if (role != Qt::EditRole || !index.isValid() || index.row() >= m_rows.size() || !m_dir) {
+        return false;
+    }
+
+    const QString oldName = m_rows.at(index.row()).name;
+    const QString newName = value.toString().trimmed();
+    if (newName.isEmpty() || newName == oldName || newName.contains(QLatin1Char('/'))) {
+        return false;
+    }
+    if (rowForName(newName) >= 0) {
+        return false;
+    }
+
+    const QUrl oldUrl = url(index);
+    QUrl newUrl = oldUrl.adjusted(QUrl::RemoveFilename);
+    newUrl.setPath(newUrl.path() + newName);
+    KIO::SimpleJob *job = FileOpsService::rename(oldUrl, newUrl, this);
+    if (!job) return false;
+
+    // Show the new name right away; a failed job relists to roll it back.
+    const QUrl dirUrl = m_dir->url();
+    QPointer<MillerDirectoryCache> cache = m_cache;
+    connect(job, &KJob::result, this, [cache, dirUrl](KJob *finished) {
+        if (finished->error() && cache) cache->refresh(dirUrl);
+    });
+    m_dir->renameEntry(oldName, newName);
+    return true;
+}
+
+Qt::ItemFlags MillerColumnModel::flags(const QModelIndex &index) const {
+    Qt::ItemFlags f = QAbstractListModel::flags(index);
+    if (!index.isValid()) {
+        return f | Qt::ItemIsDropEnabled;
+    }
+    f |= Qt::ItemIsDragEnabled | Qt::ItemIsEditable;
+    if (isDir(index)) {
+        f |= Qt::ItemIsDropEnabled;
+    }
+    return f;
+}
+
+void MillerColumnModel::sort(int column, Qt::SortOrder order) {
+    m_sortColumn = column;
+    m_sortOrder = order;
+    ++m_rowsRevision;
+    m_sortedRows = 0;
+    applySort();
+}
+
+QStringList MillerColumnModel::mimeTypes() const {
+    return {QStringLiteral("text/uri-list")};
+}
+
+QMimeData *MillerColumnModel::mimeData(const QModelIndexList &indexes) const {
+    QList<QUrl> urls;
+    for (const QModelIndex &idx : indexes) {
+        if (idx.column() != 0) continue;
+        const QUrl u = url(idx);
+        if (u.isValid()) urls.append(u);
+    }
+    auto *data = new QMimeData;
+    data->setUrls(urls);
+    return data;
+}
+
+bool MillerColumnModel::dropMimeData(const QMimeData *data, Qt::DropAction action,
+                                     int, int, const QModelIndex &parent) {
+    if (!data || !data->hasUrls() || !m_dir) return false;
+    if (action != Qt::CopyAction && action != Qt::MoveAction) return false;
+
+    QUrl destination = m_dir->url();
+    if (parent.isValid() && isDir(parent)) {
+        destination = url(parent);
+    }
+    destination = destination.adjusted(QUrl::StripTrailingSlash);
+
+    QList<QUrl> sources;
+    const QList<QUrl> urls = data->urls();
+    for (const QUrl &source : urls) {
+        if (source.adjusted(QUrl::StripTrailingSlash) == destination) continue;
+        // Moving an item onto its own folder is a no-op, not a conflict.
+        const QUrl sourceParent = source.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+        if (action == Qt::MoveAction && sourceParent == destination) continue;
+        sources.append(source);
+    }
+    if (sources.isEmpty()) return false;
+
+    if (action == Qt::MoveAction) {
+        FileOpsService::move(sources, destination, this);
+    } else {
+        FileOpsService::copy(sources, destination, this);
+    }
+    return true;
+}
+
+Qt::DropActions MillerColumnModel::supportedDropActions() const {
+    return Qt::CopyAction | Qt::MoveAction;
+}
+
+Qt::DropActions MillerColumnModel::supportedDragActions() const {
+    return Qt::CopyAction | Qt::MoveAction;
+}
+
+bool MillerColumnModel::acceptsEntry(const MillerEntry &entry) const {
+    return m_showHidden || !entry.isHidden;
+}
+
+int MillerColumnModel::rowForName(const QString &name) const {
+    if (!m_rowIndexValid) {
+        m_rowForName.clear();
+        m_rowForName.reserve(m_rows.size());
+        for (int row = 0; row < m_rows.size(); ++row) {
+            m_rowForName.insert(m_rows.at(row).name, row);
+        }
+        m_rowIndexValid = true;
+    }
+    return m_rowForName.value(name, -1);
+}
+
+void MillerColumnModel::resetSearchIndex() {
+    m_searchKeys.clear();
+    m_searchBuffer.clear();
+    m_searchOffsets.clear();
+    m_searchKeysBuilt = false;
+    m_searchRowsValid = false;
+}
+
+void MillerColumnModel::ensureSearchIndex() const {
+    if (!m_searchKeysBuilt) {
+        // Built on first use rather than per listing batch; most columns are
+        // never searched.
+        m_searchKeys.clear();
+        m_searchKeys.reserve(m_rows.size());
+        for (const MillerEntry &entry : m_rows) {
+            m_searchKeys.append({entry.name.toCaseFolded(), entry.name, -1});
+        }
+        std::sort(m_searchKeys.begin(), m_searchKeys.end(), [](const SearchKey &l, const SearchKey &r) {
+            return searchKeyLess(l.folded, l.name, r.folded, r.name);
+        });
+        m_searchKeysBuilt = true;
+        m_searchRowsValid = false;
+    }
+    if (m_searchRowsValid) return;
+
+    QVector<int> keyForRow(m_rows.size(), -1);
+    for (int i = 0; i < m_searchKeys.size(); ++i) {
+        SearchKey &key = m_searchKeys[i];
+        key.row = rowForName(key.name);
+        if (key.row >= 0) keyForRow[key.row] = i;
+    }
+
+    m_searchBuffer.clear();
+    m_searchOffsets.clear();
+    m_searchOffsets.reserve(m_rows.size());
+    for (int row = 0; row < m_rows.size(); ++row) {
+        m_searchOffsets.append(int(m_searchBuffer.size()));
+        if (keyForRow.at(row) >= 0) m_searchBuffer += m_searchKeys.at(keyForRow.at(row)).folded;
+        m_searchBuffer += QLatin1Char('\n');
+    }
+    m_searchRowsValid = true;
+}
+
+void MillerColumnModel::insertSearchKeys(const QVector<MillerEntry> &entries) {
+    m_searchRowsValid = false;
+    if (!m_searchKeysBuilt || entries.isEmpty()) return;
+
+    // Sort the batch and merge it in: linear per batch instead of per entry.
+    const auto middle = m_searchKeys.size();
+    for (const MillerEntry &entry : entries) {
+        m_searchKeys.append({entry.name.toCaseFolded(), entry.name, -1});
+    }
+    const auto less = [](const SearchKey &l, const SearchKey &r) {
+        return searchKeyLess(l.folded, l.name, r.folded, r.name);
+    };
+    std::sort(m_searchKeys.begin() + middle, m_searchKeys.end(), less);
+    std::inplace_merge(m_searchKeys.begin(), m_searchKeys.begin() + middle, m_searchKeys.end(), less);
+}
+
+void MillerColumnModel::removeSearchKeys(const QStringList &names) {
+    m_searchRowsValid = false;
+    if (!m_searchKeysBuilt || names.isEmpty()) return;
+
+    if (names.size() == 1) {
+        const QString folded = names.first().toCaseFolded();
+        const auto it = std::lower_bound(m_searchKeys.begin(), m_searchKeys.end(), names.first(),
+            [&folded](const SearchKey &key, const QString &name) {
+                return searchKeyLess(key.folded, key.name, folded, name);
+            });
+        if (it != m_searchKeys.end() && it->name == names.first()) m_searchKeys.erase(it);
+        return;
+    }
+    const QSet<QString> removed(names.cbegin(), names.cend());
+    m_searchKeys.removeIf([&removed](const SearchKey &key) { return removed.contains(key.name); });
+}
+
+void MillerColumnModel::scheduleSort() {
+    if (m_sortScheduled) return;
+    m_sortScheduled = true;
+    // Same idea as QFileSystemModel's delayed sort: one pass per event-loop turn.
+    QTimer::singleShot(0, this, [this]() {
+        if (m_sortScheduled) applySort();
+    });
+}
+
+void MillerColumnModel::applySort() {
+    m_sortScheduled = false;
+    // A running job re-enters here when it lands and picks up what changed.
+    if (m_sortJob) return;
+    const int count = m_rows.size();
+    if (m_sortedRows >= count || count < 2) {
+        m_sortedRows = count;
+        finishLoadingIfReady();
+        return;
+    }
+
+    if (count < AsyncSortThreshold) {
+        applySortResult(MillerSortEngine::sort(m_rows, m_sortedRows, m_sortColumn, m_sortOrder), count);
+        finishLoadingIfReady();
+        return;
+    }
+
+    // Large folders sort on a worker; the view keeps its current order until
+    // the whole permutation can be applied in one layout change.
+    auto *watcher = new QFutureWatcher<MillerSortEngine::Result>(this);
+    m_sortJob = watcher;
+    const quint64 revision = m_rowsRevision;
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, revision, count]() {
+        watcher->deleteLater();
+        m_sortJob = nullptr;
+        // Rows changed, went away or were reset meanwhile: the result is stale.
+        if (revision == m_rowsRevision) applySortResult(watcher->result(), count);
+        applySort();
+    });
+    watcher->setFuture(QtConcurrent::run(&MillerSortEngine::sort, m_rows, m_sortedRows, m_sortColumn, m_sortOrder));
+}
+
+void MillerColumnModel::applySortResult(MillerSortEngine::Result result, int count) {
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    QVector<int> newRowOf(count);
+    for (int row = 0; row < count; ++row) {
+        newRowOf[result.order.at(row)] = row;
+    }
+    const QModelIndexList before = persistentIndexList();
+    QModelIndexList after;
+    after.reserve(before.size());
+    for (const QModelIndex &idx : before) {
+        after.append(idx.row() < count ? index(newRowOf.at(idx.row()), idx.column()) : idx);
+    }
+
+    // Rows appended while a worker sorted stay behind the sorted block.
+    QVector<MillerEntry> rows = std::move(result.rows);
+    rows.reserve(m_rows.size());
+    for (int row = count; row < m_rows.size(); ++row) {
+        rows.append(m_rows.at(row));
+    }
+    m_rows = std::move(rows);
+    m_sortedRows = count;
+    m_rowIndexValid = false;
+    m_searchRowsValid = false;
+
+    changePersistentIndexList(before, after);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void MillerColumnModel::finishLoadingIfReady() {
+    if (!m_loadPending || !m_dir || !m_dir->isComplete()) return;
+    if (m_sortJob || m_sortedRows < m_rows.size()) return;
+    m_loadPending = false;
+    emit directoryLoaded();
+}
+
+void MillerColumnModel::onEntriesAdded(const QVector<MillerEntry> &entries) {
+    QVector<MillerEntry> visible;
+    visible.reserve(entries.size());
+    for (const MillerEntry &entry : entries) {
+        if (acceptsEntry(entry)) visible.append(entry);
+    }
+    if (visible.isEmpty()) return;
+
+    const int first = m_rows.size();
+    beginInsertRows(QModelIndex(), first, first + visible.size() - 1);
+    m_rows += visible;
+    endInsertRows();
+    m_rowIndexValid = false;
+    insertSearchKeys(visible);
+    scheduleSort();
+}
+
+void MillerColumnModel::onEntriesRemoved(const QStringList &names) {
+    const QSet<QString> removed(names.cbegin(), names.cend());
+    for (int row = m_rows.size() - 1; row >= 0; --row) {
+        if (!removed.contains(m_rows.at(row).name)) continue;
+        int first = row;
+        while (first > 0 && removed.contains(m_rows.at(first - 1).name)) --first;
+        beginRemoveRows(QModelIndex(), first, row);
+        m_rows.remove(first, row - first + 1);
+        m_sortedRows -= qBound(0, m_sortedRows - first, row - first + 1);
+        ++m_rowsRevision;
+        endRemoveRows();
+        row = first;
+    }
+    m_rowIndexValid = false;
+    removeSearchKeys(names);
+}
+
+void MillerColumnModel::onEntriesChanged(const QVector<MillerEntry> &entries) {
+    bool any = false;
+    for (const MillerEntry &entry : entries) {
+        const int row = rowForName(entry.name);
+        if (row < 0) continue;
+        // Under a name sort only a file/folder flip can move a row.
+        if (m_sortColumn != 0 || m_rows.at(row).isDir != entry.isDir) m_sortedRows = 0;
+        m_rows[row] = entry;
+        ++m_rowsRevision;
+        const QModelIndex idx = index(row, 0);
+        emit dataChanged(idx, idx);
+        any = true;
+    }
+    if (any) scheduleSort();
+}
+
+void MillerColumnModel::onEntryRenamed(const QString &oldName, const MillerEntry &entry) {
+    const int row = rowForName(oldName);
+    ++m_rowsRevision;
+    if (row >= 0) removeSearchKeys({oldName});
+    if (acceptsEntry(entry)) insertSearchKeys({entry});
+    if (row >= 0 && acceptsEntry(entry)) {
+        m_rows[row] = entry;
+        m_rowIndexValid = false;
+        m_sortedRows = 0;
+        const QModelIndex idx = index(row, 0);
+        emit dataChanged(idx, idx);
+    } else if (row >= 0) {
+        beginRemoveRows(QModelIndex(), row, row);
+        m_rows.remove(row);
+        if (row < m_sortedRows) --m_sortedRows;
+        endRemoveRows();
+        m_rowIndexValid = false;
+        return;
+    } else if (acceptsEntry(entry)) {
+        beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size());
+        m_rows.append(entry);
+        endInsertRows();
+        m_rowIndexValid = false;
+    } else {
+        return;
+    }
+    scheduleSort();
+}
+
+void MillerColumnModel::onCompleted() {
+    // Sorts whatever is still pending, then reports the folder as loaded.
+    applySort();
+}
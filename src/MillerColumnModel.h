@@ -0,0 +1,103 @@
+#pragma once
+#include "MillerDirectoryCache.h"
+#include "MillerSortEngine.h"
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QPointer>
+#include <QUrl>
+#include <QVector>
+
+class QFutureWatcherBase;
+
+// Flat model for one Miller column: a filtered, sorted view onto a single
+// MillerDirectory held in the pane-wide MillerDirectoryCache.
+class MillerColumnModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    explicit MillerColumnModel(MillerDirectoryCache *cache, QObject *parent = nullptr);
+    ~MillerColumnModel() override;
+
+    void setDirectory(const QUrl &url);
+    QUrl directoryUrl() const;
+    bool isLoaded() const;
+    void setShowHiddenFiles(bool show);
+
+    QUrl url(const QModelIndex &index) const;
+    QString filePath(const QModelIndex &index) const;
+    QString fileName(const QModelIndex &index) const;
+    bool isDir(const QModelIndex &index) const;
+    bool isSymLink(const QModelIndex &index) const;
+    QModelIndex indexForName(const QString &name) const;
+    // Type-to-select: first row whose name starts with text, otherwise the
+    // first row containing it (case-insensitive).
+    QModelIndex findName(const QString &text) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // Drag & drop routed through FileOpsService (KIO jobs, undoable).
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+    bool dropMimeData(const QMimeData *data, Qt::DropAction action,
+                      int row, int column, const QModelIndex &parent) override;
+    Qt::DropActions supportedDropActions() const override;
+    Qt::DropActions supportedDragActions() const override;
+
+signals:
+    // Emitted once per folder, when it finished listing and rows are sorted.
+    void directoryLoaded();
+
+private:
+    struct SearchKey {
+        QString folded;
+        QString name;
+        int row = -1;
+    };
+
+    void detach();
+    bool acceptsEntry(const MillerEntry &entry) const;
+    QUrl urlForName(const QString &name) const;
+    int rowForName(const QString &name) const;
+    void loadRows();
+    void scheduleSort();
+    void applySort();
+    void applySortResult(MillerSortEngine::Result result, int count);
+    void finishLoadingIfReady();
+    void resetSearchIndex();
+    void ensureSearchIndex() const;
+    void insertSearchKeys(const QVector<MillerEntry> &entries);
+    void removeSearchKeys(const QStringList &names);
+
+    void onEntriesAdded(const QVector<MillerEntry> &entries);
+    void onEntriesRemoved(const QStringList &names);
+    void onEntriesChanged(const QVector<MillerEntry> &entries);
+    void onEntryRenamed(const QString &oldName, const MillerEntry &entry);
+    void onCompleted();
+
+    QPointer<MillerDirectoryCache> m_cache;
+    QPointer<MillerDirectory> m_dir;
+    QUrl m_url;
+    QVector<MillerEntry> m_rows;
+    mutable QHash<QString, int> m_rowForName;
+    mutable bool m_rowIndexValid = false;
+    // Search index: case-folded names sorted for prefix lookups, plus all
+    // folded names in row order ('\n'-separated) for substring matches.
+    // Keys follow inserts/removals; rows and buffer are redone after reorders.
+    mutable QVector<SearchKey> m_searchKeys;
+    mutable QString m_searchBuffer;
+    mutable QVector<int> m_searchOffsets;  // start of each row in m_searchBuffer
+    mutable bool m_searchKeysBuilt = false;
+    mutable bool m_searchRowsValid = false;
+    int m_sortedRows = 0;  // leading rows already in sort order; the rest get merged in
+    int m_sortColumn = 0;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+    bool m_showHidden = false;
+    bool m_sortScheduled = false;
+    QFutureWatcherBase *m_sortJob = nullptr;
+    quint64 m_rowsRevision = 0;  // bumped whenever existing rows change; appends don't count
+    bool m_loadPending = false;  // directoryLoaded not yet emitted for this folder
+};
@@ -0,0 +1,461 @@
+#include "MillerDirectoryCache.h"
+#include "MillerSortEngine.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QMimeDatabase>
+#include <QPromise>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <KCoreDirLister>
+#include <KFileItem>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Listing batches start at about a screenful so a column shows rows almost
+// immediately, then grow to keep per-batch overhead low in huge folders.
+constexpr int FirstBatchSize = 64;
+constexpr int MaxBatchSize = 4096;
+constexpr int MaxBatchIntervalMs = 50;  // slow filesystems still trickle in
+
+struct MillerDirectoryDiff {
+    QVector<MillerEntry> entries;
+    QVector<MillerEntry> added;
+    QVector<MillerEntry> changed;
+    QStringList removed;
+};
+
+MillerEntry entryForFileInfo(const QFileInfo &fi, const QMimeDatabase &mimeDb, const QCollator &collator,
+                             QHash<QString, QString> &iconNames) {
+    MillerEntry entry;
+    entry.name = fi.fileName();
+    // Built here, on the listing worker, so columns never collate on the GUI thread.
+    entry.nameKey = collator.sortKey(entry.name);
+    entry.isDir = fi.isDir();
+    entry.isSymLink = fi.isSymLink();
+    entry.isHidden = entry.name.startsWith(QLatin1Char('.'));
+    entry.modifiedMs = fi.lastModified().toMSecsSinceEpoch();
+    if (entry.isDir) {
+        entry.mimeType = QStringLiteral("inode/directory");
+        entry.iconName = QStringLiteral("folder");
+        return entry;
+    }
+
+    entry.size = fi.size();
+    // Extension-only matching: content sniffing would read every file.
+    const QMimeType mt = mimeDb.mimeTypeForFile(fi, QMimeDatabase::MatchExtension);
+    entry.mimeType = mt.name();
+    auto it = iconNames.find(entry.mimeType);
+    if (it == iconNames.end()) {
+        it = iconNames.insert(entry.mimeType, mt.iconName());
+    }
+    entry.iconName = it.value();
+    return entry;
+}
+
+MillerEntry entryForFileItem(const KFileItem &item) {
+    MillerEntry entry;
+    entry.url = item.url();
+    entry.name = item.name();
+    entry.isDir = item.isDir();
+    entry.isSymLink = item.isLink();
+    entry.isHidden = item.isHidden();
+    entry.modifiedMs = item.time(KFileItem::ModificationTime).toMSecsSinceEpoch();
+    if (!entry.isDir) entry.size = static_cast<qint64>(item.size());
+    // currentMimeType() never sniffs content, which would mean a remote read.
+    entry.mimeType = item.currentMimeType().name();
+    entry.iconName = item.iconName();
+    return entry;
+}
+
+void listLocalDirectory(QPromise<QVector<MillerEntry>> &promise, const QString &path) {
+    const QMimeDatabase mimeDb;
+    const QCollator collator = MillerSortEngine::collator();
+    QHash<QString, QString> iconNames;
+    int batchSize = FirstBatchSize;
+    QVector<MillerEntry> batch;
+    batch.reserve(batchSize);
+    QElapsedTimer sinceBatch;
+    sinceBatch.start();
+
+    QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+    while (it.hasNext()) {
+        if (promise.isCanceled()) return;
+        it.next();
+        batch.append(entryForFileInfo(it.fileInfo(), mimeDb, collator, iconNames));
+        if (batch.size() >= batchSize || sinceBatch.elapsed() >= MaxBatchIntervalMs) {
+            promise.addResult(std::move(batch));
+            batchSize = qMin(batchSize * 4, MaxBatchSize);
+            batch = QVector<MillerEntry>();
+            batch.reserve(batchSize);
+            sinceBatch.restart();
+        }
+    }
+    if (!batch.isEmpty()) {
+        promise.addResult(std::move(batch));
+    }
+}
+
+MillerDirectoryDiff diffLocalDirectory(const QString &path, const QVector<MillerEntry> &previous) {
+    MillerDirectoryDiff diff;
+    const QMimeDatabase mimeDb;
+    const QCollator collator = MillerSortEngine::collator();
+    QHash<QString, QString> iconNames;
+
+    QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+    while (it.hasNext()) {
+        it.next();
+        diff.entries.append(entryForFileInfo(it.fileInfo(), mimeDb, collator, iconNames));
+    }
+
+    QHash<QString, int> previousByName;
+    previousByName.reserve(previous.size());
+    for (int i = 0; i < previous.size(); ++i) {
+        previousByName.insert(previous.at(i).name, i);
+    }
+
+    for (const MillerEntry &entry : std::as_const(diff.entries)) {
+        auto found = previousByName.find(entry.name);
+        if (found == previousByName.end()) {
+            diff.added.append(entry);
+            continue;
+        }
+        const MillerEntry &old = previous.at(found.value());
+        if (old.size != entry.size || old.modifiedMs != entry.modifiedMs
+            || old.isDir != entry.isDir || old.isSymLink != entry.isSymLink
+            || old.mimeType != entry.mimeType) {
+            diff.changed.append(entry);
+        }
+        previousByName.erase(found);
+    }
+    diff.removed = previousByName.keys();
+    return diff;
+}
+
+}
+
+MillerDirectory::MillerDirectory(const QUrl &url, QObject *parent) : QObject(parent), m_url(url) {}
+
+QString MillerDirectory::localPath() const {
+    return m_url.isLocalFile() ? m_url.toLocalFile() : QString();
+}
+
+void MillerDirectory::renameEntry(const QString &oldName, const QString &newName) {
+    for (MillerEntry &entry : m_entries) {
+        if (entry.name != oldName) continue;
+        entry.name = newName;
+        entry.nameKey.reset();
+        entry.isHidden = newName.startsWith(QLatin1Char('.'));
+        if (entry.url.isValid()) {
+            QUrl renamed = entry.url.adjusted(QUrl::RemoveFilename);
+            renamed.setPath(renamed.path() + newName);
+            entry.url = renamed;
+        }
+        ++m_revision;
+        emit entryRenamed(oldName, entry);
+        return;
+    }
+}
+
+MillerDirectoryCache::MillerDirectoryCache(QObject *parent) : QObject(parent) {
+    m_pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 4));
+
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &MillerDirectoryCache::onDirectoryChanged);
+
+    // Coalesce bursts of change notifications (e.g. a large copy) into one relist.
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(150);
+    connect(m_refreshTimer, &QTimer::timeout, this, &MillerDirectoryCache::flushPendingRefreshes);
+}
+
+MillerDirectoryCache::~MillerDirectoryCache() {
+    for (MillerDirectory *dir : std::as_const(m_dirs)) {
+        if (dir->m_job) dir->m_job->cancel();
+    }
+    m_pool.waitForDone();
+}
+
+QString MillerDirectoryCache::keyForUrl(const QUrl &url) {
+    if (url.isLocalFile()) {
+        return QDir::cleanPath(url.toLocalFile());
+    }
+    return url.adjusted(QUrl::StripTrailingSlash).toString();
+}
+
+MillerDirectory *MillerDirectoryCache::acquire(const QUrl &url) {
+    if (!url.isValid()) return nullptr;
+
+    const QString key = keyForUrl(url);
+    MillerDirectory *dir = m_dirs.value(key);
+    if (!dir) {
+        dir = new MillerDirectory(url.isLocalFile() ? QUrl::fromLocalFile(key) : url, this);
+        m_dirs.insert(key, dir);
+        startListing(dir);
+    } else if (dir->m_refCount == 0) {
+        m_unused.removeOne(dir);
+        if (dir == m_prefetch || dir->m_lister) {
+            // Watched since the prefetch started (or kept current by its
+            // lister); keep the listing, finished or not, as it is.
+            if (dir == m_prefetch) m_prefetch = nullptr;
+            ++dir->m_refCount;
+            return dir;
+        }
+        // Nothing watched the folder while it sat unused; revalidate it.
+        if (dir->m_complete) startRefresh(dir);
+    }
+
+    if (++dir->m_refCount == 1 && dir->m_url.isLocalFile()) {
+        m_watcher->addPath(key);
+    }
+    return dir;
+}
+
+void MillerDirectoryCache::release(MillerDirectory *dir) {
+    if (!dir || dir->m_refCount <= 0) return;
+    if (--dir->m_refCount > 0) return;
+
+    if (dir->m_url.isLocalFile()) {
+        m_watcher->removePath(keyForUrl(dir->m_url));
+    }
+    m_unused.append(dir);
+    trimUnused();
+}
+
+void MillerDirectoryCache::refresh(const QUrl &url) {
+    if (MillerDirectory *dir = m_dirs.value(keyForUrl(url))) {
+        startRefresh(dir);
+    }
+}
+
+void MillerDirectoryCache::prefetch(const QUrl &url) {
+    if (!url.isValid()) return;
+
+    const QString key = keyForUrl(url);
+    MillerDirectory *dir = m_dirs.value(key);
+    if (dir && dir == m_prefetch) return;
+    cancelPrefetch();
+
+    if (dir) {
+        // Already cached; just keep it from aging out of the LRU.
+        if (dir->m_refCount == 0) {
+            m_unused.removeOne(dir);
+            m_unused.append(dir);
+        }
+        return;
+    }
+
+    dir = new MillerDirectory(url.isLocalFile() ? QUrl::fromLocalFile(key) : url, this);
+    m_dirs.insert(key, dir);
+    m_unused.append(dir);
+    m_prefetch = dir;
+    if (dir->m_url.isLocalFile()) {
+        m_watcher->addPath(key);
+    }
+    startListing(dir);
+    trimUnused();
+}
+
+void MillerDirectoryCache::cancelPrefetch() {
+    MillerDirectory *dir = std::exchange(m_prefetch, nullptr);
+    if (!dir) return;
+
+    if (dir->m_url.isLocalFile()) {
+        m_watcher->removePath(keyForUrl(dir->m_url));
+    }
+    // A finished listing stays cached; a half-listed one is not worth the I/O.
+    if (!dir->m_complete) {
+        m_unused.removeOne(dir);
+        destroyDirectory(dir);
+    }
+}
+
+QIcon MillerDirectoryCache::iconForEntry(const MillerEntry &entry) {
+    auto it = m_icons.constFind(entry.iconName);
+    if (it != m_icons.constEnd()) return it.value();
+
+    QIcon icon = QIcon::fromTheme(entry.iconName);
+    if (icon.isNull()) {
+        icon = QIcon::fromTheme(entry.isDir ? QStringLiteral("folder") : QStringLiteral("text-x-generic"));
+    }
+    m_icons.insert(entry.iconName, icon);
+    return icon;
+}
+
+void MillerDirectoryCache::startListing(MillerDirectory *dir) {
+    const QString path = dir->localPath();
+    if (path.isEmpty()) {
+        startRemoteListing(dir);
+        return;
+    }
+
+    auto *watcher = new QFutureWatcher<QVector<MillerEntry>>(dir);
+    dir->m_job = watcher;
+    connect(watcher, &QFutureWatcherBase::resultsReadyAt, dir, [dir, watcher](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const QVector<MillerEntry> batch = watcher->resultAt(i);
+            dir->m_entries += batch;
+            emit dir->entriesAdded(batch);
+        }
+    });
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, dir, watcher]() {
+        watcher->deleteLater();
+        dir->m_job = nullptr;
+        dir->m_complete = true;
+        emit dir->completed();
+        if (dir->m_refreshPending) {
+            dir->m_refreshPending = false;
+            startRefresh(dir);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(&m_pool, listLocalDirectory, path));
+}
+
+void MillerDirectoryCache::startRemoteListing(MillerDirectory *dir) {
+    // The lister keeps itself current through KDirNotify, so remote folders
+    // need neither the file watcher nor the revalidation relist.
+    auto *lister = new KCoreDirLister(dir);
+    dir->m_lister = lister;
+    lister->setAutoErrorHandlingEnabled(false);
+    lister->setShowHiddenFiles(true);  // columns filter hidden entries themselves
+
+    connect(lister, &KCoreDirLister::itemsAdded, dir, [dir](const QUrl &, const KFileItemList &items) {
+        QVector<MillerEntry> batch;
+        batch.reserve(items.size());
+        for (const KFileItem &item : items) {
+            batch.append(entryForFileItem(item));
+        }
+        dir->m_entries += batch;
+        emit dir->entriesAdded(batch);
+    });
+    connect(lister, &KCoreDirLister::itemsDeleted, dir, [dir](const KFileItemList &items) {
+        QStringList names;
+        for (const KFileItem &item : items) {
+            names.append(item.name());
+        }
+        const QSet<QString> removed(names.cbegin(), names.cend());
+        dir->m_entries.removeIf([&removed](const MillerEntry &entry) { return removed.contains(entry.name); });
+        emit dir->entriesRemoved(names);
+    });
+    connect(lister, &KCoreDirLister::refreshItems, dir,
+            [dir](const QList<QPair<KFileItem, KFileItem>> &items) {
+        QVector<MillerEntry> changed;
+        for (const auto &pair : items) {
+            const MillerEntry entry = entryForFileItem(pair.second);
+            const QString oldName = pair.first.name();
+            auto it = std::find_if(dir->m_entries.begin(), dir->m_entries.end(),
+                                   [&oldName](const MillerEntry &e) { return e.name == oldName; });
+            if (it == dir->m_entries.end()) {
+                // Already renamed locally by renameEntry().
+                it = std::find_if(dir->m_entries.begin(), dir->m_entries.end(),
+                                  [&entry](const MillerEntry &e) { return e.name == entry.name; });
+                if (it == dir->m_entries.end()) continue;
+            }
+            if (it->name != entry.name) {
+                *it = entry;
+                emit dir->entryRenamed(oldName, entry);
+            } else {
+                *it = entry;
+                changed.append(entry);
+            }
+        }
+        if (!changed.isEmpty()) emit dir->entriesChanged(changed);
+    });
+    auto finish = [dir]() {
+        // completed() repeats after every update; columns only need the first.
+        if (dir->m_complete) return;
+        dir->m_complete = true;
+        emit dir->completed();
+    };
+    connect(lister, qOverload<>(&KCoreDirLister::completed), dir, finish);
+    connect(lister, qOverload<>(&KCoreDirLister::canceled), dir, finish);
+
+    lister->openUrl(dir->m_url);
+}
+
+void MillerDirectoryCache::startRefresh(MillerDirectory *dir) {
+    if (dir->m_lister) {
+        dir->m_lister->updateDirectory(dir->m_url);
+        return;
+    }
+    const QString path = dir->localPath();
+    if (path.isEmpty()) return;
+    if (dir->m_job) {
+        dir->m_refreshPending = true;
+        return;
+    }
+
+    auto *watcher = new QFutureWatcher<MillerDirectoryDiff>(dir);
+    dir->m_job = watcher;
+    const int revision = dir->m_revision;
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, dir, watcher, revision]() {
+        watcher->deleteLater();
+        dir->m_job = nullptr;
+        if (watcher->isCanceled()) return;
+        // A local rename landed while listing; the diff base is stale.
+        if (revision != dir->m_revision) {
+            startRefresh(dir);
+            return;
+        }
+
+        const MillerDirectoryDiff diff = watcher->result();
+        dir->m_entries = diff.entries;
+        if (!diff.removed.isEmpty()) emit dir->entriesRemoved(diff.removed);
+        if (!diff.changed.isEmpty()) emit dir->entriesChanged(diff.changed);
+        if (!diff.added.isEmpty()) emit dir->entriesAdded(diff.added);
+
+        if (dir->m_refreshPending) {
+            dir->m_refreshPending = false;
+            startRefresh(dir);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(&m_pool, diffLocalDirectory, path, dir->m_entries));
+}
+
+void MillerDirectoryCache::onDirectoryChanged(const QString &path) {
+    if (!m_pendingRefreshes.contains(path)) {
+        m_pendingRefreshes.append(path);
+    }
+    m_refreshTimer->start();
+}
+
+void MillerDirectoryCache::flushPendingRefreshes() {
+    const QStringList paths = std::exchange(m_pendingRefreshes, {});
+    for (const QString &path : paths) {
+        if (MillerDirectory *dir = m_dirs.value(path)) {
+            startRefresh(dir);
+        }
+    }
+}
+
+void MillerDirectoryCache::trimUnused() {
+    while (m_unused.size() > MaxUnusedDirectories) {
+        destroyDirectory(m_unused.takeFirst());
+    }
+}
+
+void MillerDirectoryCache::destroyDirectory(MillerDirectory *dir) {
+    if (!dir) return;
+    if (dir == m_prefetch) {
+        m_prefetch = nullptr;
+        if (dir->m_url.isLocalFile()) m_watcher->removePath(keyForUrl(dir->m_url));
+    }
+    if (dir->m_job) {
+        disconnect(dir->m_job, nullptr, nullptr, nullptr);
+        dir->m_job->cancel();
+    }
+    if (dir->m_lister) {
+        disconnect(dir->m_lister, nullptr, nullptr, nullptr);
+        dir->m_lister->stop();
+    }
+    m_dirs.remove(keyForUrl(dir->m_url));
+    dir->deleteLater();
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <QObject>
+#include <QCollatorSortKey>
+#include <QHash>
+#include <QIcon>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QUrl>
+#include <QVector>
+#include <optional>
+
+class KCoreDirLister;
+class KFileItem;
+class QFileSystemWatcher;
+class QFutureWatcherBase;
+class QTimer;
+
+// One directory entry as produced by a listing job. Plain value type so
+// batches can be built on worker threads and handed to the GUI thread.
+struct MillerEntry {
+    QUrl url;  // only set by KIO listings, whose items may live elsewhere (search results)
+    QString name;
+    QString mimeType;
+    QString iconName;
+    qint64 size = 0;
+    qint64 modifiedMs = 0;
+    bool isDir = false;
+    bool isSymLink = false;
+    bool isHidden = false;
+    std::optional<QCollatorSortKey> nameKey;  // see MillerSortEngine; filled lazily
+};
+
+// A single listed directory shared by every Miller column that shows it.
+// Entries are kept in listing order; columns apply their own filter/sort.
+class MillerDirectory : public QObject {
+    Q_OBJECT
+public:
+    QUrl url() const { return m_url; }
+    QString localPath() const;
+    const QVector<MillerEntry> &entries() const { return m_entries; }
+    bool isComplete() const { return m_complete; }
+
+    // Apply a rename locally so views keep their selection while the
+    // rename job and the follow-up refresh catch up.
+    void renameEntry(const QString &oldName, const QString &newName);
+
+signals:
+    void entriesAdded(const QVector<MillerEntry> &entries);
+    void entriesRemoved(const QStringList &names);
+    void entriesChanged(const QVector<MillerEntry> &entries);
+    void entryRenamed(const QString &oldName, const MillerEntry &entry);
+    void completed();
+
+private:
+    friend class MillerDirectoryCache;
+    MillerDirectory(const QUrl &url, QObject *parent);
+
+    QUrl m_url;
+    QVector<MillerEntry> m_entries;
+    QFutureWatcherBase *m_job = nullptr;
+    KCoreDirLister *m_lister = nullptr;  // non-local URLs only
+    int m_refCount = 0;
+    int m_revision = 0;
+    bool m_complete = false;
+    bool m_refreshPending = false;
+};
+
+// Per-pane listing cache behind all Miller columns. Local folders are listed
+// on a worker pool; everything else goes through an async KCoreDirLister
+// whose items stream in on the GUI thread as KIO delivers them. Directories are
+// reference counted: referenced ones are watched for changes, released and
+// prefetched ones stay in a small LRU so going back or stepping into the
+// highlighted folder is instant.
+class MillerDirectoryCache : public QObject {
+    Q_OBJECT
+public:
+    explicit MillerDirectoryCache(QObject *parent = nullptr);
+    ~MillerDirectoryCache() override;
+
+    MillerDirectory *acquire(const QUrl &url);
+    void release(MillerDirectory *dir);
+    void refresh(const QUrl &url);
+
+    // Start listing a folder nobody shows yet (the highlighted one) so that
+    // opening it finds it populated. Only one prefetch runs at a time; a new
+    // request or cancelPrefetch() abandons an unfinished one.
+    void prefetch(const QUrl &url);
+    void cancelPrefetch();
+
+    QIcon iconForEntry(const MillerEntry &entry);
+
+    // Normalized identity of a folder URL (clean path for local folders).
+    static QString keyForUrl(const QUrl &url);
+
+private:
+    void startListing(MillerDirectory *dir);
+    void startRemoteListing(MillerDirectory *dir);
+    void startRefresh(MillerDirectory *dir);
+    void onDirectoryChanged(const QString &path);
+    void flushPendingRefreshes();
+    void trimUnused();
+    void destroyDirectory(MillerDirectory *dir);
+
+    static constexpr int MaxUnusedDirectories = 16;
+
+    QHash<QString, MillerDirectory*> m_dirs;
+    QList<MillerDirectory*> m_unused;  // least recently released first
+    MillerDirectory *m_prefetch = nullptr;  // unreferenced, watched while set
+    QFileSystemWatcher *m_watcher = nullptr;
+    QTimer *m_refreshTimer = nullptr;
+    QStringList m_pendingRefreshes;
+    QHash<QString, QIcon> m_icons;
+    QThreadPool m_pool;
+};
@@ -0,0 +1,119 @@
+#include "MillerSortEngine.h"
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+constexpr int ParallelThreshold = 20000;
+
+struct SortRange {
+    int begin = 0;
+    int end = 0;
+};
+
+int compareEntries(const MillerEntry &left, const MillerEntry &right, int column) {
+    int cmp = 0;
+    switch (column) {
+    case 1:  // Size
+        cmp = left.size < right.size ? -1 : (left.size > right.size ? 1 : 0);
+        break;
+    case 2:  // Type
+        cmp = QString::compare(left.mimeType, right.mimeType);
+        break;
+    case 3:  // Date Modified
+        cmp = left.modifiedMs < right.modifiedMs ? -1 : (left.modifiedMs > right.modifiedMs ? 1 : 0);
+        break;
+    default:
+        break;
+    }
+    if (cmp == 0) cmp = left.nameKey->compare(*right.nameKey);
+    return cmp;
+}
+
+// Splits [begin, end) into one range per core.
+QVector<SortRange> splitRange(int begin, int end) {
+    const int parts = qMax(1, QThread::idealThreadCount());
+    const int step = (end - begin + parts - 1) / parts;
+    QVector<SortRange> ranges;
+    for (int from = begin; from < end; from += step) {
+        ranges.append({from, qMin(end, from + step)});
+    }
+    return ranges;
+}
+
+}
+
+QCollator MillerSortEngine::collator() {
+    QCollator collator;
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    return collator;
+}
+
+void MillerSortEngine::ensureSortKeys(QVector<MillerEntry> &rows) {
+    const auto fill = [&rows](const SortRange &range) {
+        const QCollator keyCollator = collator();
+        for (int i = range.begin; i < range.end; ++i) {
+            MillerEntry &entry = rows[i];
+            if (!entry.nameKey) entry.nameKey = keyCollator.sortKey(entry.name);
+        }
+    };
+    rows.detach();
+    if (rows.size() < ParallelThreshold) {
+        fill({0, int(rows.size())});
+        return;
+    }
+    QVector<SortRange> ranges = splitRange(0, rows.size());
+    QtConcurrent::blockingMap(ranges, fill);
+}
+
+MillerSortEngine::Result MillerSortEngine::sort(QVector<MillerEntry> rows, int sortedRows,
+                                                int column, Qt::SortOrder order) {
+    ensureSortKeys(rows);
+
+    const int count = rows.size();
+    sortedRows = qBound(0, sortedRows, count);
+    // Ties fall back to the old row, which makes every pass stable.
+    const auto less = [&rows, column, order](int left, int right) {
+        const MillerEntry &l = rows.at(left);
+        const MillerEntry &r = rows.at(right);
+        if (l.isDir != r.isDir) return l.isDir;
+        const int cmp = compareEntries(l, r, column);
+        if (cmp != 0) return order == Qt::AscendingOrder ? cmp < 0 : cmp > 0;
+        return left < right;
+    };
+
+    Result result;
+    result.order.resize(count);
+    std::iota(result.order.begin(), result.order.end(), 0);
+
+    const auto first = result.order.begin();
+    if (count - sortedRows < ParallelThreshold) {
+        std::sort(first + sortedRows, result.order.end(), less);
+    } else {
+        // Sort one slice per core, then merge the slices pairwise.
+        QVector<SortRange> ranges = splitRange(sortedRows, count);
+        QtConcurrent::blockingMap(ranges, [&](const SortRange &range) {
+            std::sort(first + range.begin, first + range.end, less);
+        });
+        while (ranges.size() > 1) {
+            QVector<SortRange> merged;
+            for (int i = 0; i + 1 < ranges.size(); i += 2) {
+                std::inplace_merge(first + ranges.at(i).begin, first + ranges.at(i).end,
+                                   first + ranges.at(i + 1).end, less);
+                merged.append({ranges.at(i).begin, ranges.at(i + 1).end});
+            }
+            if (ranges.size() % 2) merged.append(ranges.last());
+            ranges = merged;
+        }
+    }
+    std::inplace_merge(first, first + sortedRows, result.order.end(), less);
+
+    result.rows.reserve(count);
+    for (int oldRow : std::as_const(result.order)) {
+        result.rows.append(std::move(rows[oldRow]));
+    }
+    return result;
+}
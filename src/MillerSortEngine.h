@@ -0,0 +1,25 @@
+#pragma once
+#include "MillerDirectoryCache.h"
+
+#include <QCollator>
+#include <QVector>
+#include <Qt>
+
+// Sort engine behind Miller columns. Names are compared through collation
+// keys (natural numeric, case-insensitive) built once per entry and kept on
+// the entry, so sorting never calls QCollator::compare. Safe to run on a
+// worker thread: it only touches the rows it is given.
+class MillerSortEngine {
+public:
+    struct Result {
+        QVector<int> order;         // new row -> old row
+        QVector<MillerEntry> rows;  // rows in their new order, keys filled in
+    };
+
+    static QCollator collator();
+    static void ensureSortKeys(QVector<MillerEntry> &rows);
+
+    // Rows [0, sortedRows) are already in order; the rest are sorted (in
+    // parallel when there are many) and merged in. Folders always come first.
+    static Result sort(QVector<MillerEntry> rows, int sortedRows, int column, Qt::SortOrder order);
+};
@@ -1,7 +1,9 @@
 #include "MillerView.h"
 #include "FileOpsService.h"
-#include <memory>
-#include <QFileSystemModel>
+#include "MillerColumnModel.h"
+#include "MillerDirectoryCache.h"
+#include "ThumbnailDelegate.h"
+#include <QDir>
 #include <QFileInfo>
 #include <QHBoxLayout>
 #include <QKeyEvent>
@@ -10,63 +12,252 @@
 #include <QLineEdit>
 #include <QTimer>
 #include <QListView>
+#include <memory>
+#include <utility>
 
 MillerView::MillerView(QWidget *parent) : QWidget(parent) {
     layout = new QHBoxLayout(this);
     layout->setContentsMargins(0,0,0,0);
     layout->setSpacing(0);
+    m_cache = new MillerDirectoryCache(this);
+
+    // Minimal styling - let theme handle colors, just add selection behavior.
+    // Set once here so recycled and new columns inherit it without re-parsing.
+    setStyleSheet(
+        "QListView { "
+        "  border: none; "
+        "  border-right: 1px solid palette(mid); "
+        "}"
+        "QListView::item { "
+        "  padding: 2px 4px; "
+        "  border-radius: 4px; "
+        "  margin: 1px 2px; "
+        "}"
+        "QListView::item:selected { "
+        "  background-color: palette(highlight); "
+        "  color: palette(highlighted-text); "
+        "}"
+        "QListView::item:selected:!active { "
+        "  background-color: #505050; "
+        "  color: palette(highlighted-text); "
+        "}"
+        "QScrollBar:vertical { "
+        "  background-color: transparent; width: 12px; border-radius: 6px; "
+        "}"
+        "QScrollBar::handle:vertical { "
+        "  background-color: palette(mid); border-radius: 6px; min-height: 20px; margin: 2px; "
+        "}"
+        "QScrollBar::add-line:vertical, QScrollBar::sub-line:vertical { height: 0px; }"
+        "QScrollBar:horizontal { "
+        "  background-color: transparent; height: 12px; border-radius: 6px; "
+        "}"
+        "QScrollBar::handle:horizontal { "
+        "  background-color: palette(mid); border-radius: 6px; min-width: 20px; margin: 2px; "
+        "}"
+        "QScrollBar::add-line:horizontal, QScrollBar::sub-line:horizontal { width: 0px; }"
+    );
+}
+
+static MillerColumnModel *columnModel(const QListView *view) {
+    return view ? qobject_cast<MillerColumnModel*>(view->model()) : nullptr;
+}
+
+static ThumbnailDelegate *thumbnailDelegate(const QListView *view) {
+    return qobject_cast<ThumbnailDelegate*>(view->itemDelegate());
+}
+
+static QUrl parentFolderUrl(const QUrl &url) {
+    if (url.isLocalFile()) {
+        const QString path = QDir::cleanPath(url.toLocalFile());
+        if (path == QLatin1String("/")) return QUrl();
+        return QUrl::fromLocalFile(QFileInfo(path).path());
+    }
+    // Query URLs such as filenamesearch:/ have no meaningful parents.
+    if (url.hasQuery() || url.path().isEmpty() || url.path() == QLatin1String("/")) return QUrl();
+    QUrl parent = url.adjusted(QUrl::StripTrailingSlash).adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+    if (parent.path().isEmpty()) parent.setPath(QStringLiteral("/"));
+    return parent;
+}
+
+static bool isAncestorOrSelf(const QString &ancestorKey, const QString &key) {
+    if (key == ancestorKey) return true;
+    return key.startsWith(ancestorKey.endsWith(QLatin1Char('/')) ? ancestorKey : ancestorKey + QLatin1Char('/'));
+}
+
+// Folders shown left to right for url: its ancestors down to url itself.
+// The chain starts at preferredBase when that is an ancestor (so an existing
+// chain is extended rather than cut), else at home for paths under it, else
+// at the filesystem or server root.
+static QList<QUrl> columnChainFor(const QUrl &url, const QUrl &preferredBase) {
+    const QString targetKey = MillerDirectoryCache::keyForUrl(url);
+    const QString baseKey = preferredBase.isValid() ? MillerDirectoryCache::keyForUrl(preferredBase) : QString();
+    const QString homeKey = QDir::cleanPath(QDir::homePath());
+    QString stopKey;
+    if (!baseKey.isEmpty() && isAncestorOrSelf(baseKey, targetKey)) {
+        stopKey = baseKey;
+    } else if (url.isLocalFile() && isAncestorOrSelf(homeKey, targetKey)) {
+        stopKey = homeKey;
+    }
+
+    QList<QUrl> chain{url};
+    while (MillerDirectoryCache::keyForUrl(chain.first()) != stopKey) {
+        const QUrl parent = parentFolderUrl(chain.first());
+        if (!parent.isValid()) break;
+        chain.prepend(parent);
+    }
+    return chain;
 }
 
 void MillerView::setRootUrl(const QUrl &url) {
     root = url;
-    QLayoutItem *child;
-    while ((child = layout->takeAt(0)) != nullptr) {
-        if (child->widget()) child->widget()->deleteLater();
-        delete child;
+
+    const QUrl currentBase = columns.isEmpty() ? QUrl() : columnModel(columns.first())->directoryUrl();
+    QList<QUrl> chain = columnChainFor(url, currentBase);
+    if (chain.size() > MaxColumns) chain = chain.mid(chain.size() - MaxColumns);
+
+    // Keep the columns already showing a prefix of the new chain (breadcrumb
+    // clicks, back/forward); only the divergent tail is replaced.
+    int keep = 0;
+    while (keep < columns.size() && keep < chain.size()
+           && MillerDirectoryCache::keyForUrl(columnModel(columns.at(keep))->directoryUrl())
+              == MillerDirectoryCache::keyForUrl(chain.at(keep))) {
+        ++keep;
+    }
+    while (columns.size() > keep) {
+        recycleColumn(columns.takeLast());
     }
-    columns.clear();
-    addColumn(url);
+
+    emit navigatedTo(url);
+
+    // Kept columns keep their scroll position; only fix up which folder
+    // they highlight when it no longer matches the next column.
+    for (int i = 0; i < keep && i + 1 < chain.size(); ++i) {
+        QListView *view = columns.at(i);
+        auto *model = columnModel(view);
+        const QString childName = chain.at(i + 1).fileName();
+        if (model->fileName(view->currentIndex()) == childName) continue;
+        if (model->isLoaded()) {
+            selectAncestorEntry(view, childName, QAbstractItemView::EnsureVisible);
+        } else {
+            m_pendingCurrentName.insert(view, childName);
+        }
+    }
+
+    QVector<QListView*> added;
+    for (int i = keep; i < chain.size(); ++i) {
+        QListView *view = appendColumn();
+        // Ancestors highlight the folder shown in the next column once loaded.
+        if (i + 1 < chain.size()) m_pendingCurrentName.insert(view, chain.at(i + 1).fileName());
+        added.append(view);
+    }
+    columns.last()->setFocus(Qt::OtherFocusReason);
+
+    // Listings start target first: the cache pool runs them concurrently in
+    // submission order, so the column asked for fills before its ancestors.
+    for (int i = added.size() - 1; i >= 0; --i) {
+        columnModel(added.at(i))->setDirectory(chain.at(keep + i));
+    }
+}
+
+void MillerView::selectAncestorEntry(QListView *view, const QString &name, QAbstractItemView::ScrollHint hint) {
+    auto *model = columnModel(view);
+    const QModelIndex idx = model ? model->indexForName(name) : QModelIndex();
+    if (!idx.isValid()) return;
+    // Not a user selection: no preview update and no prefetch.
+    m_selectingAncestor = true;
+    view->setCurrentIndex(idx);
+    m_selectingAncestor = false;
+    view->scrollTo(idx, hint);
 }
 
 void MillerView::pruneColumnsAfter(QListView *view) {
     const int pos = columns.indexOf(view);
     if (pos < 0) return;
     while (columns.size() > pos + 1) {
-        QListView *last = columns.takeLast();
-        layout->removeWidget(last);
-        last->deleteLater();
+        recycleColumn(columns.takeLast());
+    }
+}
+
+void MillerView::recycleColumn(QListView *view) {
+    if (!view) return;
+    layout->removeWidget(view);
+    view->hide();
+
+    // Resetting the model below drops any open editor without closeEditor.
+    if (m_isEditing && m_editingView == view) {
+        disconnect(m_closeEditorConnection);
+        m_closeEditorConnection = {};
+        m_isEditing = false;
+    }
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_pendingCurrentName.remove(view);
+    if (m_renameClickView == view) {
+        m_renameClickTimer.invalidate();
+        m_renameClickIndex = QPersistentModelIndex();
+        m_renameClickView = nullptr;
+    }
+
+    // Release the folder reference (and its watch) while the view sits idle.
+    if (auto *model = columnModel(view)) {
+        model->setDirectory(QUrl());
+    }
+
+    if (m_columnPool.size() >= MaxPooledColumns) {
+        view->deleteLater();
+        return;
     }
+    m_columnPool.push_back(view);
 }
 
 void MillerView::addColumn(const QUrl &url) {
     // Enforce maximum column limit to prevent unbounded memory growth
     while (columns.size() >= MaxColumns) {
-        QListView *oldest = columns.takeFirst();
-        layout->removeWidget(oldest);
-        oldest->deleteLater();
+        recycleColumn(columns.takeFirst());
     }
 
     emit navigatedTo(url);
 
-    auto *view = new QListView(this);
-    auto *model = new QFileSystemModel(view);
-    const QString rootPath = url.toLocalFile();
-    model->setRootPath(rootPath);
-    model->setReadOnly(false);  // Enable drag & drop modifications
+    QListView *view = appendColumn();
+    view->setFocus(Qt::OtherFocusReason);
 
-    // Set hidden file filter based on current setting
-    QDir::Filters filters = QDir::AllEntries | QDir::NoDotAndDotDot;
-    if (m_showHiddenFiles) {
-        filters |= QDir::Hidden;
-    }
-    model->setFilter(filters);
+    // Listing is async; an already-cached folder reports loaded immediately.
+    columnModel(view)->setDirectory(url);
+}
+
+QListView *MillerView::appendColumn() {
+    QListView *view = m_columnPool.isEmpty() ? createColumn() : m_columnPool.takeLast();
+    auto *model = columnModel(view);
+    model->setShowHiddenFiles(m_showHiddenFiles);
+    model->sort(m_sortColumn, m_sortOrder);
+    thumbnailDelegate(view)->setThumbnailsEnabled(m_showThumbnails);
+    view->setMinimumWidth(m_columnWidth);
+    view->scrollToTop();
+
+    layout->addWidget(view);
+    columns.push_back(view);
+    view->show();
+    return view;
+}
+
+QListView *MillerView::createColumn() {
+    auto *view = new QListView(this);
+    // Columns share one listing cache; each model is just a sorted view onto one folder.
+    // The model lives as long as the view and is re-targeted when the column is reused.
+    auto *model = new MillerColumnModel(m_cache, view);
 
     view->setModel(model);
-    view->setRootIndex(model->index(rootPath));
+    // Thumbnails come from the pane-independent cache, decoded for visible rows only.
+    view->setItemDelegate(new ThumbnailDelegate(view, [model](const QModelIndex &index) {
+        return model->url(index);
+    }));
     view->setSelectionMode(QAbstractItemView::ExtendedSelection); // allow multi
     view->setSelectionBehavior(QAbstractItemView::SelectRows);
     view->setEditTriggers(QAbstractItemView::NoEditTriggers);     // no rename on dblclick
-    view->setMinimumWidth(m_columnWidth);
+    // Rows are one icon + one line: uniform sizes make layout O(1) per row
+    // and batched layout keeps six-figure folders from blocking the UI.
+    view->setUniformItemSizes(true);
+    view->setLayoutMode(QListView::Batched);
+    view->setBatchSize(256);
 
     // Enable drag and drop between columns
     view->setDragEnabled(true);
@@ -75,40 +266,6 @@ void MillerView::addColumn(const QUrl &url) {
     view->setDragDropMode(QAbstractItemView::DragDrop);
     view->setDefaultDropAction(Qt::MoveAction);  // Default to move (like Finder)
 
-    // Minimal styling - let theme handle colors, just add selection behavior
-    view->setStyleSheet(
-        "QListView { "
-        "  border: none; "
-        "  border-right: 1px solid palette(mid); "
-        "}"
-        "QListView::item { "
-        "  padding: 2px 4px; "
-        "  border-radius: 4px; "
-        "  margin: 1px 2px; "
-        "}"
-        "QListView::item:selected { "
-        "  background-color: palette(highlight); "
-        "  color: palette(highlighted-text); "
-        "}"
-        "QListView::item:selected:!active { "
-        "  background-color: #505050; "
-        "  color: palette(highlighted-text); "
-        "}"
-        "QScrollBar:vertical { "
-        "  background-color: transparent; width: 12px; border-radius: 6px; "
-        "}"
-        "QScrollBar::handle:vertical { "
-        "  background-color: palette(mid); border-radius: 6px; min-height: 20px; margin: 2px; "
-        "}"
-        "QScrollBar::add-line:vertical, QScrollBar::sub-line:vertical { height: 0px; }"
-        "QScrollBar:horizontal { "
-        "  background-color: transparent; height: 12px; border-radius: 6px; "
-        "}"
-        "QScrollBar::handle:horizontal { "
-        "  background-color: palette(mid); border-radius: 6px; min-width: 20px; margin: 2px; "
-        "}"
-        "QScrollBar::add-line:horizontal, QScrollBar::sub-line:horizontal { width: 0px; }"
-    );
 
     // Context menu
     view->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -132,22 +289,22 @@ void MillerView::addColumn(const QUrl &url) {
             if (sel) {
                 const auto indexes = sel->selectedIndexes();
                 for (const QModelIndex &i : indexes) {
-                    // Only count column 0 to avoid duplicates (model has Name, Size, Type, Date columns)
+                    // Only count column 0 to avoid duplicates
                     if (i.column() != 0) continue;
-                    QString path = model->filePath(i);
-                    if (!path.isEmpty()) {
-                        selectedUrls.append(QUrl::fromLocalFile(path));
+                    const QUrl u = model->url(i);
+                    if (u.isValid()) {
+                        selectedUrls.append(u);
                     }
                 }
             }
             // If nothing selected, use the clicked item
             if (selectedUrls.isEmpty()) {
-                selectedUrls.append(QUrl::fromLocalFile(model->filePath(idx)));
+                selectedUrls.append(model->url(idx));
             }
             emit contextMenuRequested(selectedUrls, view->mapToGlobal(pos));
         } else {
             // Empty space context menu - pass this column's folder URL
-            QUrl folderUrl = QUrl::fromLocalFile(model->rootPath());
+            const QUrl folderUrl = model->directoryUrl();
             emit emptySpaceContextMenuRequested(folderUrl, view->mapToGlobal(pos));
         }
     });
@@ -155,27 +312,32 @@ void MillerView::addColumn(const QUrl &url) {
     // ---- Open helper (used by double-click and Right/Enter) ----
     auto openIndex = [this, model, view](const QModelIndex &idx){
         if (!idx.isValid()) return;
-        const QString p = model->filePath(idx);
-        if (p.isEmpty()) return;
+        const QUrl u = model->url(idx);
+        if (!u.isValid()) return;
 
         pruneColumnsAfter(view);
 
-        QFileInfo fi(p);
-        if (fi.isDir()) {
-            if (fi.isSymLink() && !m_followSymlinks) {
+        if (model->isDir(idx)) {
+            if (model->isSymLink(idx) && !m_followSymlinks) {
                 return;
             }
-            addColumn(QUrl::fromLocalFile(p));
+            addColumn(u);
         } else {
-            FileOpsService::openUrl(QUrl::fromLocalFile(p), this);
+            FileOpsService::openUrl(u, this);
         }
     };
 
-    // Selection changes for preview pane only
+    // Selection changes drive the preview pane and prefetch the highlighted
+    // folder, so stepping into it shows an already listed column.
     connect(view->selectionModel(), &QItemSelectionModel::currentChanged, this,
             [this, model](const QModelIndex &current, const QModelIndex &) {
-        if (current.isValid()) {
-            emit selectionChanged(QUrl::fromLocalFile(model->filePath(current)));
+        if (!current.isValid() || m_selectingAncestor) return;
+        const QUrl u = model->url(current);
+        emit selectionChanged(u);
+        if (model->isDir(current) && (m_followSymlinks || !model->isSymLink(current))) {
+            m_cache->prefetch(u);
+        } else {
+            m_cache->cancelPrefetch();
         }
     });
 
@@ -201,16 +363,12 @@ void MillerView::addColumn(const QUrl &url) {
             m_renameClickTimer.restart();
         }
 
-        const QString path = model->filePath(idx);
-        if (path.isEmpty()) return;
-
-        QFileInfo fi(path);
-        if (fi.isDir()) {
-            if (fi.isSymLink() && !m_followSymlinks) {
+        if (model->isDir(idx)) {
+            if (model->isSymLink(idx) && !m_followSymlinks) {
                 return;
             }
             pruneColumnsAfter(view);
-            addColumn(QUrl::fromLocalFile(path));
+            addColumn(model->url(idx));
         }
     });
 
@@ -225,41 +383,43 @@ void MillerView::addColumn(const QUrl &url) {
     // Keyboard handling for open/back/quicklook
     view->installEventFilter(this);
 
-    layout->addWidget(view);
-    columns.push_back(view);
-    view->setFocus(Qt::OtherFocusReason);
-
-    // Select first item after model is loaded AND sorted
-    QPointer<QListView> vptr(view);
-    QPointer<QFileSystemModel> mptr(model);
-
-    // Track if we've already selected (to avoid re-selecting on every layoutChanged)
-    auto selected = std::make_shared<bool>(false);
-
-    // When directory loads, trigger sort
-    connect(model, &QFileSystemModel::directoryLoaded, this,
-        [this, mptr, rootPath](const QString &loaded){
-            if (!mptr) return;
-            if (loaded == rootPath) {
-                mptr->sort(m_sortColumn, m_sortOrder);
-            }
+    // Rows merged in while a big folder streams (or a re-sort) must not move
+    // the highlighted row out from under the user: keep it at the same
+    // distance from the top of the viewport.
+    auto anchor = std::make_shared<QPair<QPersistentModelIndex, int>>();
+    connect(model, &QAbstractItemModel::layoutAboutToBeChanged, view, [view, anchor]() {
+        const QModelIndex current = view->currentIndex();
+        const QModelIndex top = view->indexAt(QPoint(0, 0));
+        if (current.isValid() && top.isValid() && view->viewport()->rect().intersects(view->visualRect(current))) {
+            *anchor = {QPersistentModelIndex(current), current.row() - top.row()};
+        } else {
+            *anchor = {};
         }
-    );
+    });
+    connect(model, &QAbstractItemModel::layoutChanged, view, [view, model, anchor]() {
+        const QPersistentModelIndex current = std::exchange(anchor->first, QPersistentModelIndex());
+        if (!current.isValid()) return;
+        const int topRow = qMax(0, current.row() - anchor->second);
+        view->scrollTo(model->index(topRow, 0), QAbstractItemView::PositionAtTop);
+    });
 
-    // When layout changes (after sort), select first item
-    connect(model, &QAbstractItemModel::layoutChanged, this,
-        [vptr, mptr, selected](){
-            if (!vptr || !mptr || *selected) return;
-            QModelIndex r = vptr->rootIndex();
-            int rows = mptr->rowCount(r);
-            if (rows > 0) {
-                QModelIndex first = mptr->index(0, 0, r);
-                vptr->setCurrentIndex(first);
-                vptr->scrollTo(first, QAbstractItemView::PositionAtTop);
-                *selected = true;
-            }
+    // Select first item after model is loaded AND sorted (once per folder;
+    // refreshes do not emit directoryLoaded again).
+    connect(model, &MillerColumnModel::directoryLoaded, view, [this, view, model](){
+        const QString pending = m_pendingCurrentName.take(view);
+        if (!pending.isEmpty()) {
+            // Ancestor column: highlight the folder shown to its right.
+            selectAncestorEntry(view, pending, QAbstractItemView::PositionAtCenter);
+            return;
         }
-    );
+        if (model->rowCount() == 0) return;
+        if (!view->currentIndex().isValid()) {
+            view->setCurrentIndex(model->index(0, 0));
+        }
+        view->scrollTo(view->currentIndex(), QAbstractItemView::PositionAtTop);
+    });
+
+    return view;
 }
 
 bool MillerView::eventFilter(QObject *obj, QEvent *event) {
@@ -277,7 +437,7 @@ bool MillerView::eventFilter(QObject *obj, QEvent *event) {
         return false;
     }
 
-    auto *model = qobject_cast<QFileSystemModel*>(view->model());
+    auto *model = columnModel(view);
     if (!model) return QWidget::eventFilter(obj, event);
 
     if (ke->key() == Qt::Key_Space) {
@@ -293,13 +453,10 @@ bool MillerView::eventFilter(QObject *obj, QEvent *event) {
         // Right arrow: only enter directories, do nothing on files (Finder behavior)
         QModelIndex idx = view->currentIndex();
         if (!idx.isValid()) return true;
-        const QString p = model->filePath(idx);
-        if (p.isEmpty()) return true;
 
-        QFileInfo fi(p);
-        if (fi.isDir()) {
+        if (model->isDir(idx)) {
             pruneColumnsAfter(view);
-            addColumn(QUrl::fromLocalFile(p));
+            addColumn(model->url(idx));
         }
         // On files: do nothing (classic Finder behavior)
         return true;
@@ -315,16 +472,15 @@ bool MillerView::eventFilter(QObject *obj, QEvent *event) {
             // Ctrl+Enter: open/enter selection.
             QModelIndex idx = view->currentIndex();
             if (!idx.isValid()) return true;
-            const QString p = model->filePath(idx);
-            if (p.isEmpty()) return true;
+            const QUrl u = model->url(idx);
+            if (!u.isValid()) return true;
 
             pruneColumnsAfter(view);
 
-            QFileInfo fi(p);
-            if (fi.isDir()) {
-                addColumn(QUrl::fromLocalFile(p));
+            if (model->isDir(idx)) {
+                addColumn(u);
             } else {
-                FileOpsService::openUrl(QUrl::fromLocalFile(p), this);
+                FileOpsService::openUrl(u, this);
             }
             return true;
         }
@@ -351,21 +507,18 @@ bool MillerView::eventFilter(QObject *obj, QEvent *event) {
 
     if (ke->key() == Qt::Key_Left) {
         if (columns.size() > 1) {
-            QListView *last = columns.takeLast();
-            layout->removeWidget(last);
-            last->deleteLater();
+            recycleColumn(columns.takeLast());
             QListView *prev = columns.back();
             prev->setFocus(Qt::OtherFocusReason);
             // ensure something is highlighted
+            auto *m = columnModel(prev);
             if (!prev->currentIndex().isValid()) {
-                QModelIndex r = prev->rootIndex();
-                auto *m = qobject_cast<QFileSystemModel*>(prev->model());
-                if (m && m->rowCount(r) > 0)
-                    prev->setCurrentIndex(m->index(0, 0, r));
+                if (m && m->rowCount() > 0)
+                    prev->setCurrentIndex(m->index(0, 0));
             }
             // Emit URL of current (previous) column
-            if (auto *m = qobject_cast<QFileSystemModel*>(prev->model())) {
-                emit navigatedTo(QUrl::fromLocalFile(m->rootPath()));
+            if (m) {
+                emit navigatedTo(m->directoryUrl());
             }
         }
         return true;
@@ -395,6 +548,7 @@ void MillerView::beginInlineRename(QListView *view, const QModelIndex &idx) {
     view->setEditTriggers(QAbstractItemView::AllEditTriggers);
     view->edit(idx);
     m_isEditing = true;
+    m_editingView = view;
 
     QAbstractItemDelegate *delegate = view->itemDelegate();
     if (delegate) {
@@ -430,32 +584,15 @@ void MillerView::renameSelected() {
 }
 
 void MillerView::typeToSelect(QListView *view, const QString &text) {
-    auto *model = qobject_cast<QFileSystemModel*>(view->model());
+    auto *model = columnModel(view);
     if (!model) return;
 
-    QModelIndex root = view->rootIndex();
-    int rowCount = model->rowCount(root);
-
-    // Find first item that starts with the search string (case-insensitive)
-    for (int i = 0; i < rowCount; ++i) {
-        QModelIndex idx = model->index(i, 0, root);
-        QString fileName = model->fileName(idx);
-        if (fileName.startsWith(text, Qt::CaseInsensitive)) {
-            view->setCurrentIndex(idx);
-            view->scrollTo(idx);
-            return;
-        }
-    }
-
-    // If no prefix match, try contains match
-    for (int i = 0; i < rowCount; ++i) {
-        QModelIndex idx = model->index(i, 0, root);
-        QString fileName = model->fileName(idx);
-        if (fileName.contains(text, Qt::CaseInsensitive)) {
-            view->setCurrentIndex(idx);
-            view->scrollTo(idx);
-            return;
-        }
+    // First prefix match, else first substring match (case-insensitive),
+    // answered from the column's search index.
+    const QModelIndex idx = model->findName(text);
+    if (idx.isValid()) {
+        view->setCurrentIndex(idx);
+        view->scrollTo(idx);
     }
 }
 
@@ -467,14 +604,13 @@ void MillerView::focusLastColumn() {
 
     last->setFocus(Qt::OtherFocusReason);
 
-    auto *model = qobject_cast<QFileSystemModel*>(last->model());
+    auto *model = columnModel(last);
     if (!model) return;
 
     QModelIndex current = last->currentIndex();
     if (!current.isValid()) {
-        QModelIndex root = last->rootIndex();
-        if (model->rowCount(root) > 0) {
-            current = model->index(0, 0, root);
+        if (model->rowCount() > 0) {
+            current = model->index(0, 0);
             last->setCurrentIndex(current);
             last->scrollTo(current, QAbstractItemView::PositionAtTop);
         }
@@ -504,7 +640,7 @@ QList<QUrl> MillerView::getSelectedUrls() const {
         focusedView = columns.last();
     }
 
-    auto *model = qobject_cast<QFileSystemModel*>(focusedView->model());
+    auto *model = columnModel(focusedView);
     if (!model) return urls;
 
     QItemSelectionModel *sel = focusedView->selectionModel();
@@ -513,9 +649,9 @@ QList<QUrl> MillerView::getSelectedUrls() const {
     const auto indexes = sel->selectedIndexes();
     for (const QModelIndex &idx : indexes) {
         if (idx.column() != 0) continue;  // Only count column 0
-        QString path = model->filePath(idx);
-        if (!path.isEmpty()) {
-            urls.append(QUrl::fromLocalFile(path));
+        const QUrl u = model->url(idx);
+        if (u.isValid()) {
+            urls.append(u);
         }
     }
 
@@ -523,9 +659,9 @@ QList<QUrl> MillerView::getSelectedUrls() const {
     if (urls.isEmpty()) {
         QModelIndex current = focusedView->currentIndex();
         if (current.isValid()) {
-            QString path = model->filePath(current);
-            if (!path.isEmpty()) {
-                urls.append(QUrl::fromLocalFile(path));
+            const QUrl u = model->url(current);
+            if (u.isValid()) {
+                urls.append(u);
             }
         }
     }
@@ -533,17 +669,25 @@ QList<QUrl> MillerView::getSelectedUrls() const {
     return urls;
 }
 
+void MillerView::setShowThumbnails(bool show) {
+    m_showThumbnails = show;
+    for (QListView *view : std::as_const(columns)) {
+        thumbnailDelegate(view)->setThumbnailsEnabled(show);
+    }
+}
+
 void MillerView::setShowHiddenFiles(bool show) {
     m_showHiddenFiles = show;
     
-    // Update all existing columns
+    // Update all existing columns, keeping each column's highlighted entry.
     for (QListView *view : columns) {
-        if (auto *model = qobject_cast<QFileSystemModel*>(view->model())) {
-            QDir::Filters filters = QDir::AllEntries | QDir::NoDotAndDotDot;
-            if (show) {
-                filters |= QDir::Hidden;
-            }
-            model->setFilter(filters);
+        auto *model = columnModel(view);
+        if (!model) continue;
+        const QString currentName = model->fileName(view->currentIndex());
+        model->setShowHiddenFiles(show);
+        const QModelIndex restored = model->indexForName(currentName);
+        if (restored.isValid()) {
+            view->setCurrentIndex(restored);
         }
     }
 }
@@ -564,8 +708,39 @@ void MillerView::setSort(int column, Qt::SortOrder order) {
     m_sortOrder = order;
 
     for (QListView *view : columns) {
-        if (auto *model = qobject_cast<QFileSystemModel*>(view->model())) {
+        if (auto *model = columnModel(view)) {
             model->sort(m_sortColumn, m_sortOrder);
         }
     }
 }
+
+QString MillerView::adjacentFilePath(const QString &currentPath, int offset) const {
+    // Find the column whose current item is the file Quick Look is showing.
+    for (QListView *view : columns) {
+        auto *model = columnModel(view);
+        if (!model) continue;
+        const QModelIndex current = view->currentIndex();
+        if (!current.isValid() || model->filePath(current) != currentPath) continue;
+
+        const int targetRow = current.row() + offset;
+        if (targetRow < 0 || targetRow >= model->rowCount()) return {};
+        return model->filePath(model->index(targetRow, 0));
+    }
+    return {};
+}
+
+bool MillerView::selectFile(const QString &filePath) {
+    const QFileInfo fi(filePath);
+    const QString parentPath = QDir::cleanPath(fi.absolutePath());
+    for (QListView *view : columns) {
+        auto *model = columnModel(view);
+        if (!model || QDir::cleanPath(model->directoryUrl().toLocalFile()) != parentPath) continue;
+        const QModelIndex idx = model->indexForName(fi.fileName());
+        if (idx.isValid()) {
+            view->setCurrentIndex(idx);
+            view->scrollTo(idx);
+            return true;
+        }
+    }
+    return false;
+}
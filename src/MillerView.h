@@ -1,14 +1,17 @@
 #pragma once
 #include <QWidget>
+#include <QAbstractItemView>
 #include <QUrl>
 #include <QVector>
 #include <QElapsedTimer>
+#include <QHash>
 #include <QMetaObject>
 #include <QPersistentModelIndex>
 #include <QPointer>
 
 class QHBoxLayout;
 class QListView;
+class MillerDirectoryCache;
 
 class MillerView : public QWidget {
     Q_OBJECT
@@ -16,6 +19,7 @@ public:
     explicit MillerView(QWidget *parent = nullptr);
     void setRootUrl(const QUrl &url);
     void setShowHiddenFiles(bool show);
+    void setShowThumbnails(bool show);
     void setFollowSymlinks(bool follow);
     void setSort(int column, Qt::SortOrder order);
     void setColumnWidth(int width);
@@ -23,6 +27,10 @@ public:
     QList<QUrl> getSelectedUrls() const;
     void renameSelected();
 
+    // Quick Look support: sibling lookup and selection sync by local path.
+    QString adjacentFilePath(const QString &currentPath, int offset) const;
+    bool selectFile(const QString &filePath);
+
 signals:
     void quickLookRequested(const QString &path);
     void contextMenuRequested(const QList<QUrl> &urls, const QPoint &globalPos);
@@ -35,16 +43,26 @@ protected:
 
 private:
     void addColumn(const QUrl &url);
+    QListView *appendColumn();
+    QListView *createColumn();
+    void recycleColumn(QListView *view);
     void pruneColumnsAfter(QListView *view);
+    void selectAncestorEntry(QListView *view, const QString &name, QAbstractItemView::ScrollHint hint);
     void typeToSelect(QListView *view, const QString &text);
     void beginInlineRename(QListView *view, const QModelIndex &idx);
 
     static constexpr int MaxColumns = 20;
+    static constexpr int MaxPooledColumns = 8;
 
     QHBoxLayout *layout = nullptr;
+    MillerDirectoryCache *m_cache = nullptr;
     QVector<QListView*> columns;
+    QVector<QListView*> m_columnPool;  // hidden, detached views ready for reuse
+    QHash<QListView*, QString> m_pendingCurrentName;  // ancestor columns still loading
+    bool m_selectingAncestor = false;
     QUrl root;
     bool m_showHiddenFiles = false;
+    bool m_showThumbnails = true;
     bool m_followSymlinks = false;
     int m_columnWidth = 200;
 
@@ -59,6 +77,7 @@ private:
 
     // Inline rename state
     bool m_isEditing = false;
+    QPointer<QListView> m_editingView;
     QMetaObject::Connection m_closeEditorConnection;
 
     // Sort state kept in sync with Pane sort actions.
@@ -0,0 +1,32 @@
+#include "NaturalSortProxyModel.h"
+#include "MillerSortEngine.h"
+#include <KDirModel>
+
+NaturalSortProxyModel::NaturalSortProxyModel(QObject *parent)
+    : KDirSortFilterProxyModel(parent), m_collator(MillerSortEngine::collator()) {
+    // Keys are per name and only need to last one sort. Drop them whenever
+    // rows go away or the order is settled, so names of deleted or renamed
+    // files do not pile up in a folder that stays open.
+    const auto clearKeys = [this]() { m_keys.clear(); };
+    connect(this, &QAbstractItemModel::modelAboutToBeReset, this, clearKeys);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, clearKeys);
+    connect(this, &QAbstractItemModel::layoutChanged, this, clearKeys);
+}
+
+bool NaturalSortProxyModel::subSortLessThan(const QModelIndex &left, const QModelIndex &right) const {
+    if (left.column() != KDirModel::Name) {
+        return KDirSortFilterProxyModel::subSortLessThan(left, right);
+    }
+    const QString leftName = left.data(Qt::DisplayRole).toString();
+    const QString rightName = right.data(Qt::DisplayRole).toString();
+    const int cmp = sortKey(leftName).compare(sortKey(rightName));
+    if (cmp != 0) return cmp < 0;
+    // Names that collate equal ("a" vs "A") keep KDE's tie-breaking.
+    return KDirSortFilterProxyModel::subSortLessThan(left, right);
+}
+
+QCollatorSortKey NaturalSortProxyModel::sortKey(const QString &name) const {
+    auto it = m_keys.constFind(name);
+    if (it == m_keys.cend()) it = m_keys.emplace(name, m_collator.sortKey(name));
+    return *it;
+}
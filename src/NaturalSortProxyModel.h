@@ -0,0 +1,24 @@
+#pragma once
+#include <KDirSortFilterProxyModel>
+
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <QHash>
+
+// Details/Icons proxy that orders names through cached collation keys, the
+// same natural, case-insensitive order Miller columns use. A sort of a
+// large folder then collates each name once instead of per comparison.
+class NaturalSortProxyModel : public KDirSortFilterProxyModel {
+    Q_OBJECT
+public:
+    explicit NaturalSortProxyModel(QObject *parent = nullptr);
+
+protected:
+    bool subSortLessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+private:
+    QCollatorSortKey sortKey(const QString &name) const;
+
+    QCollator m_collator;
+    mutable QHash<QString, QCollatorSortKey> m_keys;
+};
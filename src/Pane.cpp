@@ -2,39 +2,43 @@
 #include "Pane.h"
 #include "MillerView.h"
 #include "QuickLookDialog.h"
-#include "ThumbCache.h"
+#include "Thumbnailer.h"
+#include "ThumbnailDelegate.h"
+#include "ThumbnailPrewarmer.h"
+#include "PreviewRenderer.h"
 #include "DialogUtils.h"
 #include "PropertiesDialog.h"
 #include "FileOpsService.h"
 #include "ArchiveService.h"
 #include "OpenWithService.h"
+#include "NaturalSortProxyModel.h"
 #include <KFilePreviewGenerator>
+#include <KIO/PreviewJob>
 
 // Qt Core
 #include <QDir>
 #include <QFileInfo>
-#include <QCryptographicHash>
+#include <QFutureWatcher>
 #include <QMimeData>
 #include <QMimeDatabase>
 #include <QProcess>
 #include <QSignalBlocker>
 #include <QSettings>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
 #include <algorithm>
 #include <QTimer>
-#include <QStandardPaths>
-#include <QFileSystemModel>
 #include <QSet>
 #include <functional>
 #include <memory>
+#include <utility>
 
 // Qt GUI
 #include <QClipboard>
 #include <QGuiApplication>
-#include <QImageReader>
 #include <QCoreApplication>
 #include <QKeyEvent>
 #include <QPainter>
-#include <QFileIconProvider>
 
 // Qt Widgets
 #include <QCheckBox>
@@ -57,6 +61,7 @@
 #include <QSlider>
 #include <QSplitter>
 #include <QStackedWidget>
+#include <QStyle>
 #include <QStyledItemDelegate>
 #include <QTextEdit>
 #include <QFrame>
@@ -76,14 +81,6 @@
 #include <KUrlNavigator>
 #include <KIO/EmptyTrashJob>
 
-// External libraries
-#include <poppler-qt6.h>
-
-static bool isImageFile(const QString &path) {
-    const QByteArray fmt = QImageReader::imageFormat(path);
-    return !fmt.isEmpty();
-}
-
 static bool isArchiveFile(const QString &path) {
     return ArchiveService::canExtractArchive(path);
 }
@@ -178,7 +175,8 @@ static QString summarizeConflictPaths(const QStringList &relativePaths, int maxI
     return lines.join(QLatin1Char('\n'));
 }
 
-static QPixmap getFileTypeIcon(const QFileInfo &fi, int size = 128) {
+// sniffed: content-based type from a worker; without it only the name is used.
+static QPixmap getFileTypeIcon(const QFileInfo &fi, int size = 128, const QMimeType &sniffed = QMimeType()) {
     static const QMimeDatabase db;
     QString mimeType;
     
@@ -205,7 +203,7 @@ static QPixmap getFileTypeIcon(const QFileInfo &fi, int size = 128) {
     }
     
     // Get MIME type for files
-    auto mt = db.mimeTypeForFile(fi.filePath(), QMimeDatabase::MatchContent);
+    const QMimeType mt = sniffed.isValid() ? sniffed : db.mimeTypeForFile(fi.filePath(), QMimeDatabase::MatchExtension);
     mimeType = mt.name();
     
     // Try to get icon from MIME type
@@ -242,18 +240,6 @@ static QPixmap getFileTypeIcon(const QFileInfo &fi, int size = 128) {
     return QIcon::fromTheme("text-x-generic").pixmap(size, size);
 }
 
-static QString getThumbnailPath(const QUrl &url) {
-    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
-    if (cacheDir.isEmpty()) cacheDir = QDir::homePath() + "/.cache";
-    
-    QDir dir(cacheDir + "/kmiller/thumbs");
-    if (!dir.exists()) dir.mkpath(dir.absolutePath());
-    
-    QString urlStr = url.toString();
-    QString hash = QString(QCryptographicHash::hash(urlStr.toUtf8(), QCryptographicHash::Md5).toHex());
-    return dir.absoluteFilePath(hash + ".png");
-}
-
 static bool confirmDeleteAction(QWidget *parent, const QList<QUrl> &urls, bool permanent) {
     if (urls.isEmpty()) return false;
 
@@ -405,7 +391,7 @@ Pane::Pane(const QUrl &startUrl, QWidget *parent) : QWidget(parent) {
     hsplit->setSizes({700, 300});
 
     dirModel = new KDirModel(this);
-    proxy = new KDirSortFilterProxyModel(this);
+    proxy = new NaturalSortProxyModel(this);
     proxy->setSourceModel(dirModel);
     proxy->setSortFoldersFirst(true);
     proxy->setDynamicSortFilter(true);
@@ -442,10 +428,20 @@ Pane::Pane(const QUrl &startUrl, QWidget *parent) : QWidget(parent) {
     
     stack->addWidget(iconView);
 
-    // Dolphin-style async thumbnail generation for icon view.
-    // KFilePreviewGenerator handles visible-first priority, scroll pausing,
-    // and cut-item dimming automatically.
+    // Images and PDFs come from our Thumbnailer at the mip level matching
+    // the zoom; KFilePreviewGenerator keeps the other KIO preview plugins
+    // (video, office documents, ...) and cut-item dimming. gsthumbnail is
+    // the KIO PDF plugin; PostScript and DVI previews go with it.
+    m_iconThumbnails = new ThumbnailDelegate(iconView, [this](const QModelIndex &index) { return urlForIndex(index); });
+    iconView->setItemDelegate(m_iconThumbnails);
     m_previewGenerator = new KFilePreviewGenerator(iconView);
+    QStringList previewPlugins = KIO::PreviewJob::defaultPlugins();
+    for (const QString &ours : {QStringLiteral("imagethumbnail"), QStringLiteral("jpegthumbnail"),
+                                QStringLiteral("svgthumbnail"), QStringLiteral("rawthumbnail"),
+                                QStringLiteral("gsthumbnail")}) {
+        previewPlugins.removeAll(ours);
+    }
+    m_previewGenerator->setEnabledPlugins(previewPlugins);
     m_previewGenerator->setPreviewShown(true);
 
     detailsView = new QTreeView(this);
@@ -483,6 +479,8 @@ Pane::Pane(const QUrl &startUrl, QWidget *parent) : QWidget(parent) {
         settings.setValue(QString("view/column%1Width").arg(logicalIndex), newSize);
     });
     
+    m_detailsThumbnails = new ThumbnailDelegate(detailsView, [this](const QModelIndex &index) { return urlForIndex(index); });
+    detailsView->setItemDelegate(m_detailsThumbnails);
     stack->addWidget(detailsView);
 
     compactView = new QListView(this);
@@ -495,8 +493,22 @@ Pane::Pane(const QUrl &startUrl, QWidget *parent) : QWidget(parent) {
     compactView->setDragDropMode(QAbstractItemView::DragDrop);
     compactView->setDefaultDropAction(Qt::MoveAction);  // Finder-like behavior
     compactView->setContextMenuPolicy(Qt::CustomContextMenu);
+    m_compactThumbnails = new ThumbnailDelegate(compactView, [this](const QModelIndex &index) { return urlForIndex(index); });
+    compactView->setItemDelegate(m_compactThumbnails);
     stack->addWidget(compactView);
 
+    // Two threads: a stale decode that cannot be interrupted (a huge TIFF)
+    // must not hold up the preview of the next selection.
+    m_previewPool = new QThreadPool(this);
+    m_previewPool->setMaxThreadCount(2);
+
+    // Selection bursts (key repeat) only pay for decoding once the highlight
+    // settles on a row; see scheduleSelectionPreview().
+    m_selectionSettle = new QTimer(this);
+    m_selectionSettle->setSingleShot(true);
+    m_selectionSettle->setInterval(120);
+    connect(m_selectionSettle, &QTimer::timeout, this, &Pane::flushSelectionPreview);
+
     miller = new MillerView(this);
     stack->addWidget(miller);
     // Ensure Ctrl+A selects all in classic views
@@ -509,13 +521,7 @@ Pane::Pane(const QUrl &startUrl, QWidget *parent) : QWidget(parent) {
     connect(miller, &MillerView::quickLookRequested, this, [this](const QString &p){ if (ql && ql->isVisible()) { ql->close(); } else { if (!ql) ql = new QuickLookDialog(this); ql->showFile(p); } });
     connect(miller, &MillerView::contextMenuRequested, this, [this](const QList<QUrl> &urls, const QPoint &g){ showContextMenu(g, urls); });
     connect(miller, &MillerView::emptySpaceContextMenuRequested, this, [this](const QUrl &folderUrl, const QPoint &g){ showEmptySpaceContextMenu(g, folderUrl); });
-    connect(miller, &MillerView::selectionChanged, this, [this](const QUrl &url){
-        if (m_previewVisible) updatePreviewForUrl(url);
-        // Update QuickLook if it's open
-        if (ql && ql->isVisible() && url.isLocalFile()) {
-            ql->showFile(url.toLocalFile());
-        }
-    });
+    connect(miller, &MillerView::selectionChanged, this, &Pane::scheduleSelectionPreview);
     connect(miller, &MillerView::navigatedTo, this, [this](const QUrl &url){
         if (!url.isValid()) return;
         currentRoot = url;
@@ -524,7 +530,6 @@ Pane::Pane(const QUrl &startUrl, QWidget *parent) : QWidget(parent) {
     });
 
     ql = new QuickLookDialog(this);
-    thumbs = new ThumbCache(this);
 
     connect(viewBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &Pane::onViewModeChanged);
     connect(zoom, &QSlider::valueChanged, this, &Pane::onZoomChanged);
@@ -719,19 +724,22 @@ void Pane::setRoot(const QUrl &url) {
 
 void Pane::applyLocation(const QUrl &url) {
     currentRoot = url;
+    // Thumbnails the views queued for the old folder are no longer worth
+    // decoding; the prewarmer drops its own pass in prewarm() below.
+    for (ThumbnailDelegate *delegate : {m_iconThumbnails, m_detailsThumbnails, m_compactThumbnails}) {
+        Thumbnailer::instance()->cancel(delegate);
+    }
     if (auto *l = dirModel->dirLister()) {
         l->openUrl(url, KDirLister::OpenUrlFlags(KDirLister::Reload));
     }
 
-    // Miller view only supports local filesystem paths (QFileSystemModel).
-    // For non-local URLs (trash:/, filenamesearch://, etc.), auto-switch to
-    // Details view which uses KDirModel and handles all KIO protocols.
-    if (!url.isLocalFile() && stack->currentWidget() == miller) {
-        viewBox->setCurrentIndex(Details);
-        setViewMode(Details);
-    } else if (miller) {
+    // Miller columns list non-local URLs (trash:/, sftp://, filenamesearch:/)
+    // through KIO themselves, see MillerDirectoryCache.
+    if (miller) {
         miller->setRootUrl(url);
     }
+    // Thumbnails for the rest of the folder, made while the user looks.
+    ThumbnailPrewarmer::instance()->prewarm(url, thumbnailLevel());
 
     syncNavigatorLocation(url);
     emit urlChanged(url);
@@ -918,9 +926,23 @@ void Pane::onActivated(const QModelIndex &idx) {
 void Pane::onCurrentChanged(const QModelIndex &current, const QModelIndex &) {
     const QUrl url = urlForIndex(current);
     if (!url.isValid()) return;
+    scheduleSelectionPreview(url);
+}
+
+void Pane::scheduleSelectionPreview(const QUrl &url) {
+    // Latest wins: name/size update right away, decoding (preview pane and
+    // Quick Look) waits until the selection has been still for a moment.
+    m_pendingSelectionUrl = url;
+    if (m_previewVisible) updatePreviewMetadata(url);
+    m_selectionSettle->start();
+}
+
+void Pane::flushSelectionPreview() {
+    const QUrl url = std::exchange(m_pendingSelectionUrl, QUrl());
+    if (!url.isValid()) return;
     if (m_previewVisible) updatePreviewForUrl(url);
-    // Update Quick Look if it's open (mirrors Miller's selectionChanged handler)
-    if (ql && ql->isVisible() && url.isLocalFile()) {
+    // Quick Look's own navigation already shows the file it selects.
+    if (ql && ql->isVisible() && url.isLocalFile() && ql->currentPath() != url.toLocalFile()) {
         ql->showFile(url.toLocalFile());
     }
 }
@@ -986,6 +1008,10 @@ void Pane::setShowThumbnails(bool show) {
     if (m_previewGenerator) {
         m_previewGenerator->setPreviewShown(show);
     }
+    if (m_iconThumbnails) m_iconThumbnails->setThumbnailsEnabled(show);
+    if (m_detailsThumbnails) m_detailsThumbnails->setThumbnailsEnabled(show);
+    if (m_compactThumbnails) m_compactThumbnails->setThumbnailsEnabled(show);
+    if (miller) miller->setShowThumbnails(show);
 }
 
 void Pane::setShowFileExtensions(bool show) {
@@ -1006,72 +1032,55 @@ void Pane::setFollowSymlinks(bool follow) {
 }
 
 void Pane::clearPreview() {
+    // Whatever a worker is still rendering is for another selection now.
+    m_previewGeneration->fetch_add(1, std::memory_order_relaxed);
     if (previewImage) previewImage->setPixmap(QPixmap());
     if (previewText)  previewText->setPlainText(QString());
 }
 
+void Pane::updatePreviewMetadata(const QUrl &u) {
+    // Just a stat: no decoding and no directory listing.
+    clearPreview();
+    if (!u.isValid() || !u.isLocalFile()) return;
+    previewText->setPlainText(PreviewRenderer::caption(u.toLocalFile()));
+}
+
 void Pane::updatePreviewForUrl(const QUrl &u) {
     clearPreview();
     if (!u.isValid() || !u.isLocalFile()) return;
 
+    // Placeholder now: type icon by name and a stat-only caption. Decoding,
+    // PDF rendering, content sniffing and folder counts run on m_previewPool.
     const QString path = u.toLocalFile();
-    QFileInfo fi(path);
-
-    if (fi.isDir()) {
-        // Show folder icon
-        QPixmap folderIcon = getFileTypeIcon(fi, 128);
-        if (!folderIcon.isNull()) {
-            previewImage->setPixmap(folderIcon);
-        }
-
-        const QString displayName = fi.fileName().isEmpty() ? path : fi.fileName();
-        const int itemCount = QDir(path).entryList(QDir::NoDotAndDotDot | QDir::AllEntries).size();
-        previewText->setPlainText(QString("%1\n%2 items")
-                                  .arg(displayName)
-                                  .arg(itemCount));
-        return;
-    }
-
-    if (isImageFile(path)) {
-        QPixmap pm(path);
-        if (!pm.isNull()) {
-            // fit-to-pane while preserving aspect ratio
-            const int w = previewImage->width()  > 0 ? previewImage->width()  : 600;
-            const int h = previewImage->height() > 0 ? previewImage->height() : 300;
-            previewImage->setPixmap(pm.scaled(w, h, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-        }
-        previewText->setPlainText(QString("%1 — %2 KB")
-                                  .arg(fi.fileName())
-                                  .arg((fi.size()+1023)/1024));
-        return;
-    }
-
-    if (fi.suffix().compare("pdf", Qt::CaseInsensitive) == 0) {
-        std::unique_ptr<Poppler::Document> doc(Poppler::Document::load(path));
-        if (doc) {
-            doc->setRenderHint(Poppler::Document::Antialiasing);
-            doc->setRenderHint(Poppler::Document::TextAntialiasing);
-            std::unique_ptr<Poppler::Page> page(doc->page(0));
-            if (page) {
-                QImage img = page->renderToImage(120.0, 120.0);
-                if (!img.isNull()) {
-                    previewImage->setPixmap(QPixmap::fromImage(img));
-                }
-            }
-            previewText->setPlainText(fi.fileName());
-            return;
-        }
-    }
-
-    // Fallback - show file type icon
-    QPixmap fileIcon = getFileTypeIcon(fi, 128);
-    if (!fileIcon.isNull()) {
-        previewImage->setPixmap(fileIcon);
-    }
-    
-    previewText->setPlainText(QString("%1 — %2 KB")
-                              .arg(fi.fileName())
-                              .arg((fi.size()+1023)/1024));
+    const QFileInfo fi(path);
+    const QPixmap placeholder = getFileTypeIcon(fi, 128);
+    if (!placeholder.isNull()) previewImage->setPixmap(placeholder);
+    previewText->setPlainText(PreviewRenderer::caption(path));
+
+    // fit-to-pane while preserving aspect ratio, decoding only that many pixels
+    const int w = previewImage->width()  > 0 ? previewImage->width()  : 600;
+    const int h = previewImage->height() > 0 ? previewImage->height() : 300;
+    const qreal dpr = previewImage->devicePixelRatioF();
+    const quint64 generation = m_previewGeneration->fetch_add(1, std::memory_order_relaxed) + 1;
+    const PreviewRenderer::Generation latest = m_previewGeneration;
+
+    auto *watcher = new QFutureWatcher<PreviewRenderer::Result>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, fi, dpr]() {
+        watcher->deleteLater();
+        const PreviewRenderer::Result result = watcher->result();
+        if (result.cancelled || result.generation != m_previewGeneration->load(std::memory_order_relaxed)) return;
+        if (!result.image.isNull()) {
+            QPixmap pm = QPixmap::fromImage(result.image);
+            pm.setDevicePixelRatio(dpr);
+            previewImage->setPixmap(pm);
+        } else if (result.mimeType.isValid()) {
+            const QPixmap icon = getFileTypeIcon(fi, 128, result.mimeType);
+            if (!icon.isNull()) previewImage->setPixmap(icon);
+        }
+        previewText->setPlainText(result.text);
+    });
+    watcher->setFuture(QtConcurrent::run(m_previewPool, &PreviewRenderer::render, path,
+                                         QSize(w, h) * dpr, generation, latest));
 }
 
 void Pane::showContextMenu(const QPoint &globalPos, const QList<QUrl> &urls)
@@ -1805,87 +1814,16 @@ bool Pane::canGoForward() const {
     return m_navigationState.canGoForward();
 }
 
-void Pane::generateThumbnail(const QUrl &url) const {
-    if (!url.isLocalFile()) return;
-    
-    QString path = url.toLocalFile();
-    QFileInfo fi(path);
-    if (!fi.exists() || fi.isDir()) return;
-    
-    // Check if we already have a cached thumbnail
-    if (thumbs && thumbs->has(url)) return;
-    
-    QString thumbPath = getThumbnailPath(url);
-    QFileInfo thumbInfo(thumbPath);
-    
-    // Check if thumbnail is newer than original file
-    if (thumbInfo.exists() && thumbInfo.lastModified() >= fi.lastModified()) {
-        QPixmap thumb(thumbPath);
-        if (!thumb.isNull() && thumbs) {
-            thumbs->put(url, thumb);
-            return;
-        }
-    }
-    
-    QPixmap thumbnail;
-    
-    if (isImageFile(path)) {
-        QPixmap original(path);
-        if (!original.isNull()) {
-            thumbnail = original.scaled(128, 128, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        }
-    } else if (fi.suffix().compare("pdf", Qt::CaseInsensitive) == 0) {
-        std::unique_ptr<Poppler::Document> doc(Poppler::Document::load(path));
-        if (doc) {
-            doc->setRenderHint(Poppler::Document::Antialiasing);
-            doc->setRenderHint(Poppler::Document::TextAntialiasing);
-            std::unique_ptr<Poppler::Page> page(doc->page(0));
-            if (page) {
-                QImage img = page->renderToImage(96.0, 96.0);
-                if (!img.isNull()) {
-                    thumbnail = QPixmap::fromImage(img).scaled(128, 128, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-                }
-            }
-        }
-    }
-    
-    if (!thumbnail.isNull()) {
-        // Save thumbnail to cache
-        thumbnail.save(thumbPath, "PNG");
-        
-        // Add to memory cache
-        if (thumbs) thumbs->put(url, thumbnail);
-    }
-}
-
-QIcon Pane::getIconForFile(const QUrl &url) const {
-    if (!url.isLocalFile()) return QIcon();
-    
-    // Check if we have a thumbnail
-    if (thumbs && thumbs->has(url)) {
-        return QIcon(thumbs->get(url));
+Thumbnailer::Level Pane::thumbnailLevel() const {
+    switch (currentViewMode()) {
+    case Icons: return m_iconThumbnails->level();
+    case Details: return m_detailsThumbnails->level();
+    case Compact: return m_compactThumbnails->level();
+    default: break;
     }
-    
-    // Check if thumbnail exists on disk
-    QString thumbPath = getThumbnailPath(url);
-    if (QFileInfo(thumbPath).exists()) {
-        QPixmap thumb(thumbPath);
-        if (!thumb.isNull()) {
-            if (thumbs) thumbs->put(url, thumb);
-            return QIcon(thumb);
-        }
-    }
-    
-    // For image files, generate thumbnail asynchronously
-    QString path = url.toLocalFile();
-    if (isImageFile(path) || QFileInfo(path).suffix().compare("pdf", Qt::CaseInsensitive) == 0) {
-        // Generate thumbnail (thumbs is mutable, generateThumbnail is const)
-        generateThumbnail(url);
-    }
-    
-    // Return default icon for now
-    QFileIconProvider provider;
-    return provider.icon(QFileInfo(path));
+    // Miller columns use the style's small icons.
+    const int extent = style()->pixelMetric(QStyle::PM_SmallIconSize, nullptr, this);
+    return Thumbnailer::levelFor(extent * devicePixelRatioF());
 }
 
 void Pane::updateStatus() {
@@ -2026,44 +1964,18 @@ void Pane::refreshLocation(const QUrl &url) {
 QString Pane::adjacentFilePath(const QString &currentPath, int offset) const {
     if (currentPath.isEmpty()) return {};
 
-    // Miller view: navigate within the active column's QFileSystemModel
+    // Miller view: navigate within the active column
     if (stack->currentWidget() == miller) {
-        const auto columns = miller->findChildren<QListView*>();
-        // Find the column whose selection contains the current file
-        for (auto *col : columns) {
-            auto *fsModel = qobject_cast<QFileSystemModel*>(col->model());
-            if (!fsModel) continue;
-            QModelIndex current = col->currentIndex();
-            if (!current.isValid()) continue;
-            if (fsModel->filePath(current) == currentPath) {
-                int targetRow = current.row() + offset;
-                QModelIndex root = col->rootIndex();
-                if (targetRow < 0 || targetRow >= fsModel->rowCount(root)) return {};
-                QModelIndex target = fsModel->index(targetRow, 0, root);
-                return fsModel->filePath(target);
-            }
-        }
-        return {};
+        return miller->adjacentFilePath(currentPath, offset);
     }
 
     // Classic views: navigate within the KDirModel proxy
     if (!proxy) return {};
-    const int rows = proxy->rowCount();
-    int currentRow = -1;
-    for (int i = 0; i < rows; ++i) {
-        QModelIndex idx = proxy->index(i, 0);
-        QModelIndex src = proxy->mapToSource(idx);
-        KFileItem item = dirModel->itemForIndex(src);
-        if (item.localPath() == currentPath) {
-            currentRow = i;
-            break;
-        }
-    }
+    const QModelIndex current = proxyIndexForPath(currentPath);
+    if (!current.isValid()) return {};
 
-    if (currentRow < 0) return {};
-
-    int targetRow = currentRow + offset;
-    if (targetRow < 0 || targetRow >= rows) return {};
+    const int targetRow = current.row() + offset;
+    if (targetRow < 0 || targetRow >= proxy->rowCount()) return {};
 
     QModelIndex targetIdx = proxy->index(targetRow, 0);
     QModelIndex targetSrc = proxy->mapToSource(targetIdx);
@@ -2071,6 +1983,31 @@ QString Pane::adjacentFilePath(const QString &currentPath, int offset) const {
     return targetItem.localPath();
 }
 
+QModelIndex Pane::proxyIndexForPath(const QString &path) const {
+    // The persistent index follows sorting and inserts, so while it still
+    // points at path it is the answer without any lookup.
+    if (m_quickLookIndex.isValid() && m_quickLookPath == path
+        && dirModel->itemForIndex(proxy->mapToSource(m_quickLookIndex)).localPath() == path) {
+        return m_quickLookIndex;
+    }
+    const QModelIndex src = dirModel->indexForUrl(QUrl::fromLocalFile(path));
+    QModelIndex index = src.isValid() ? proxy->mapFromSource(src) : QModelIndex();
+    if (!index.isValid()) {
+        // trash:/, desktop:/ and other KIO folders list items under their
+        // own URLs; Quick Look knows them by local path only.
+        for (int row = 0; row < proxy->rowCount(); ++row) {
+            const QModelIndex candidate = proxy->index(row, 0);
+            if (dirModel->itemForIndex(proxy->mapToSource(candidate)).localPath() == path) {
+                index = candidate;
+                break;
+            }
+        }
+    }
+    m_quickLookPath = path;
+    m_quickLookIndex = index;
+    return index;
+}
+
 bool Pane::isMillerViewActive() const {
     return stack && stack->currentWidget() == miller;
 }
@@ -2079,27 +2016,13 @@ bool Pane::isMillerViewActive() const {
 
 void Pane::selectFileInView(const QString &filePath) {
     if (filePath.isEmpty()) return;
-    QUrl fileUrl = QUrl::fromLocalFile(filePath);
 
     if (stack->currentWidget() == miller) {
-        // Miller: find the column whose root is the file's parent directory
-        QFileInfo fi(filePath);
-        QString parentPath = fi.absolutePath();
-        for (auto *col : miller->findChildren<QListView*>()) {
-            auto *fsModel = qobject_cast<QFileSystemModel*>(col->model());
-            if (!fsModel || fsModel->rootPath() != parentPath) continue;
-            QModelIndex idx = fsModel->index(filePath);
-            if (idx.isValid()) {
-                col->setCurrentIndex(idx);
-                col->scrollTo(idx);
-                return;
-            }
-        }
+        // Miller: select in the column whose folder is the file's parent directory
+        miller->selectFile(filePath);
     } else if (proxy && dirModel) {
         // Classic views: find in the proxy model
-        QModelIndex srcIdx = dirModel->indexForUrl(fileUrl);
-        if (!srcIdx.isValid()) return;
-        QModelIndex proxyIdx = proxy->mapFromSource(srcIdx);
+        const QModelIndex proxyIdx = proxyIndexForPath(filePath);
         if (!proxyIdx.isValid()) return;
         if (auto *v = qobject_cast<QAbstractItemView*>(stack->currentWidget())) {
             v->setCurrentIndex(proxyIdx);
@@ -1,5 +1,6 @@
 #pragma once
 #include "PaneNavigationState.h"
+#include "Thumbnailer.h"
 
 #include <QWidget>
 #include <QUrl>
@@ -10,6 +11,9 @@
 #include <QPersistentModelIndex>
 #include <QPointer>
 
+#include <atomic>
+#include <memory>
+
 class QTimer;
 class QToolBar;
 class QComboBox;
@@ -20,15 +24,16 @@ class QTreeView;
 class QSplitter;
 class QLabel;
 class QTextEdit;
+class QThreadPool;
 class QAbstractItemView;
 
 class KUrlNavigator;
 class MillerView;
 class QuickLookDialog;
-class ThumbCache;
 class KDirModel;
 class KDirSortFilterProxyModel;
 class KFilePreviewGenerator;
+class ThumbnailDelegate;
 
 class Pane : public QWidget {
     Q_OBJECT
@@ -138,10 +143,17 @@ private:
     void showHeaderContextMenu(const QPoint &pos);
     void showEmptySpaceContextMenu(const QPoint &pos, const QUrl &targetFolder = QUrl());
     
-    void generateThumbnail(const QUrl &url) const;
-    QIcon getIconForFile(const QUrl &url) const;
+    // Thumbnail level the current view paints at.
+    Thumbnailer::Level thumbnailLevel() const;
+    // Proxy index of a local file in the classic views, via KDirModel's url
+    // hash, or a scan by local path in KIO folders the hash misses. The last
+    // one resolved is remembered for Quick Look stepping.
+    QModelIndex proxyIndexForPath(const QString &path) const;
 
     void updatePreviewForUrl(const QUrl &u);
+    void updatePreviewMetadata(const QUrl &u);
+    void scheduleSelectionPreview(const QUrl &url);
+    void flushSelectionPreview();
     void clearPreview();
     
     void showOpenWithDialog(const QUrl &url);
@@ -183,11 +195,20 @@ private:
     QTextEdit *previewText = nullptr;
 
     QuickLookDialog *ql = nullptr;
-    mutable ThumbCache *thumbs = nullptr;  // mutable: caching is logically const
+    QTimer *m_selectionSettle = nullptr;
+    // Preview pane rendering (PreviewRenderer); results for anything but
+    // the latest generation are dropped.
+    QThreadPool *m_previewPool = nullptr;
+    std::shared_ptr<std::atomic<quint64>> m_previewGeneration = std::make_shared<std::atomic<quint64>>(0);
+    QUrl m_pendingSelectionUrl;
 
     KDirModel *dirModel = nullptr;
     KDirSortFilterProxyModel *proxy = nullptr;
     KFilePreviewGenerator *m_previewGenerator = nullptr;
+    // Visible-range thumbnails from Thumbnailer, sized to each view's icons.
+    ThumbnailDelegate *m_iconThumbnails = nullptr;
+    ThumbnailDelegate *m_detailsThumbnails = nullptr;
+    ThumbnailDelegate *m_compactThumbnails = nullptr;
 
     QLabel *m_emptyFolderLabel = nullptr;
 
@@ -218,4 +239,8 @@ private:
     QPersistentModelIndex m_renameClickIndex;
     QElapsedTimer m_renameClickTimer;
 
+    // Quick Look session position in the classic views (proxyIndexForPath).
+    mutable QString m_quickLookPath;
+    mutable QPersistentModelIndex m_quickLookIndex;
+
 };
@@ -0,0 +1,78 @@
+#include "PreviewRenderer.h"
+#include "ImageDecoder.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMimeDatabase>
+
+#include <poppler-qt6.h>
+
+namespace {
+
+// Entries counted between cancellation checks.
+constexpr int CountBatch = 1024;
+
+bool stale(quint64 generation, const PreviewRenderer::Generation &latest) {
+    return latest && latest->load(std::memory_order_relaxed) != generation;
+}
+
+QImage renderPdfPage(const QString &path, const QSize &bound, quint64 generation,
+                     const PreviewRenderer::Generation &latest) {
+    std::unique_ptr<Poppler::Document> doc(Poppler::Document::load(path));
+    if (!doc || doc->isLocked() || stale(generation, latest)) return QImage();
+    doc->setRenderHint(Poppler::Document::Antialiasing);
+    doc->setRenderHint(Poppler::Document::TextAntialiasing);
+    std::unique_ptr<Poppler::Page> page(doc->page(0));
+    if (!page) return QImage();
+    // Pick the dpi that fits the page into bound instead of scaling afterwards.
+    const QSizeF points = page->pageSizeF();
+    if (points.isEmpty()) return QImage();
+    const qreal dpi = 72.0 * qMin(bound.width() / points.width(), bound.height() / points.height());
+    return page->renderToImage(dpi, dpi);
+}
+
+}
+
+QString PreviewRenderer::caption(const QString &path) {
+    const QFileInfo fi(path);
+    if (fi.isDir()) return fi.fileName().isEmpty() ? fi.filePath() : fi.fileName();
+    return QString("%1 — %2 KB").arg(fi.fileName()).arg((fi.size()+1023)/1024);
+}
+
+PreviewRenderer::Result PreviewRenderer::render(const QString &path, const QSize &bound, quint64 generation,
+                                                const Generation &latest) {
+    Result result;
+    result.generation = generation;
+    if (stale(generation, latest)) {
+        result.cancelled = true;
+        return result;
+    }
+
+    const QFileInfo fi(path);
+    if (fi.isDir()) {
+        int count = 0;
+        QDirIterator it(path, QDir::NoDotAndDotDot | QDir::AllEntries);
+        while (it.hasNext()) {
+            it.next();
+            if (++count % CountBatch == 0 && stale(generation, latest)) {
+                result.cancelled = true;
+                return result;
+            }
+        }
+        result.text = QString("%1\n%2 items").arg(caption(path)).arg(count);
+        return result;
+    }
+
+    result.text = caption(path);
+    if (ImageDecoder::isRawFile(path) || !QImageReader::imageFormat(path).isEmpty()) {
+        result.image = ImageDecoder::decodeScaled(path, bound);
+    } else if (fi.suffix().compare("pdf", Qt::CaseInsensitive) == 0) {
+        result.image = renderPdfPage(path, bound, generation, latest);
+        if (!result.image.isNull()) result.text = fi.fileName();
+    }
+    if (result.image.isNull()) {
+        result.mimeType = QMimeDatabase().mimeTypeForFile(path, QMimeDatabase::MatchContent);
+    }
+    result.cancelled = stale(generation, latest);
+    return result;
+}
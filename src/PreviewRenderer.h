@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QImage>
+#include <QMimeType>
+#include <QSize>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+// Worker side of the preview pane: everything that reads file contents
+// (image and PDF decoding, MIME sniffing, counting folder entries), so the
+// GUI thread only shows a placeholder and later the result. Thread-safe.
+class PreviewRenderer {
+public:
+    // Latest generation the pane asked for; older requests stop early.
+    using Generation = std::shared_ptr<const std::atomic<quint64>>;
+
+    struct Result {
+        quint64 generation = 0;
+        bool cancelled = false;
+        QImage image;        // null: show an icon for mimeType
+        QMimeType mimeType;  // sniffed from content; files only
+        QString text;
+    };
+
+    // Preview of path fitting bound (device pixels).
+    static Result render(const QString &path, const QSize &bound, quint64 generation, const Generation &latest);
+    // Cheap caption shown while render() runs: name and size, no I/O beyond a stat.
+    static QString caption(const QString &path);
+};
@@ -1,5 +1,9 @@
 #include "QuickLookDialog.h"
 #include "Pane.h"
+#include "QuickLookFrameCache.h"
+#include "QuickLookPdfView.h"
+#include "QuickLookTextView.h"
+#include "ImageDecoder.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -7,8 +11,8 @@
 #include <QImage>
 #include <QImageReader>
 #include <QPixmap>
-#include <QScrollArea>
-#include <QTextEdit>
+#include <QFrame>
+#include <QLocale>
 #include <QPushButton>
 #include <QSlider>
 #include <QFileInfo>
@@ -28,12 +32,12 @@
 #include <QScreen>
 #include <QGuiApplication>
 #include <QStyle>
+#include <QTimer>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QMediaPlayer>
 #include <QMediaMetaData>
 #include <QAudioOutput>
 #include <QVideoWidget>
-#include <poppler-qt6.h>
 #include <algorithm>
 
 static QString formatBytes(qint64 size) {
@@ -127,24 +131,58 @@ QuickLookDialog::QuickLookDialog(Pane *parentPane) : QDialog(parentPane), pane(p
     imageLabel->setStyleSheet("QLabel { background-color: #1f2127; }");
     stack->addWidget(imageLabel);  // 0
 
-    // PDF view
-    auto *pdfLabel = new QLabel;
-    pdfLabel->setAlignment(Qt::AlignCenter);
-    pdfLabel->setStyleSheet("QLabel { background-color: #1f2127; }");
-    auto *pdfScroll = new QScrollArea;
-    pdfScroll->setWidget(pdfLabel);
-    pdfScroll->setWidgetResizable(true);
-    pdfScroll->setStyleSheet("QScrollArea { background-color: #1f2127; border: none; }");
-    stack->addWidget(pdfScroll);  // 1
-
-    // Text view
-    auto *textEdit = new QTextEdit;
-    textEdit->setReadOnly(true);
-    textEdit->setStyleSheet(
-        "QTextEdit { background-color: #1f2127; color: #e5e8ed; border: none; "
-        "font-family: monospace; font-size: 13px; padding: 10px; }"
+    // PDF view: every page, rendered in tiles as it scrolls into view
+    auto *pdfPage = new QWidget;
+    auto *pdfLayout = new QVBoxLayout(pdfPage);
+    pdfLayout->setContentsMargins(0, 0, 0, 0);
+    pdfLayout->setSpacing(0);
+    pdfView = new QuickLookPdfView(pdfPage);
+    pdfView->setFrameShape(QFrame::NoFrame);
+    pdfLayout->addWidget(pdfView, 1);
+    pdfStatusLabel = new QLabel(pdfPage);
+    pdfStatusLabel->setStyleSheet(
+        "QLabel { color: #9aa3b2; background-color: #262a33; padding: 4px 10px; font-size: 11px; }"
     );
-    stack->addWidget(textEdit);  // 2
+    pdfLayout->addWidget(pdfStatusLabel);
+    connect(pdfView, &QuickLookPdfView::positionChanged, this, [this]() {
+        const QLocale locale;
+        if (pdfView->pageCount() == 0) {
+            pdfStatusLabel->setText("Opening…");
+            return;
+        }
+        pdfStatusLabel->setText(QString("Page %1 of %2   ·   %3%   ·   Ctrl+scroll to zoom, Ctrl+0 fit width")
+                                .arg(locale.toString(pdfView->currentPage() + 1),
+                                     locale.toString(pdfView->pageCount()),
+                                     QString::number(qRound(pdfView->zoom() * 100))));
+    });
+    connect(pdfView, &QuickLookPdfView::loadFailed, this, [this](const QString &path) {
+        if (path == currentFilePath) showUnsupported(path, "Unreadable PDF");
+    });
+    stack->addWidget(pdfPage);  // 1
+
+    // Text view: memory-mapped and paged, so any file size opens at once
+    auto *textPage = new QWidget;
+    auto *textLayout = new QVBoxLayout(textPage);
+    textLayout->setContentsMargins(0, 0, 0, 0);
+    textLayout->setSpacing(0);
+    textView = new QuickLookTextView(textPage);
+    textView->setFrameShape(QFrame::NoFrame);
+    textLayout->addWidget(textView, 1);
+    textStatusLabel = new QLabel(textPage);
+    textStatusLabel->setStyleSheet(
+        "QLabel { color: #9aa3b2; background-color: #262a33; padding: 4px 10px; font-size: 11px; }"
+    );
+    textLayout->addWidget(textStatusLabel);
+    connect(textView, &QuickLookTextView::positionChanged, this, [this]() {
+        const QLocale locale;
+        const qint64 first = textView->firstVisibleLine() + 1;
+        const qint64 last = qMin(textView->lineCount(), first + textView->visibleLineCount() - 1);
+        textStatusLabel->setText(QString("Lines %1–%2 of %3%4   ·   Ctrl+G go to line, Ctrl+End end of file")
+                                 .arg(locale.toString(first), locale.toString(last),
+                                      locale.toString(textView->lineCount()),
+                                      textView->isIndexing() ? QString(" (counting…)") : QString()));
+    });
+    stack->addWidget(textPage);  // 2
 
     // Media view (audio/video)
     auto *mediaPage = new QWidget;
@@ -513,69 +551,86 @@ QuickLookDialog::QuickLookDialog(Pane *parentPane) : QDialog(parentPane), pane(p
         mediaPlayer->setPosition(std::min<qint64>(duration, mediaPlayer->position() + 10000));
     });
 
+    m_frames = new QuickLookFrameCache(this);
+    connect(m_frames, &QuickLookFrameCache::frameReady, this, [this](const QString &path) {
+        if (path == m_awaitingFrame && path == currentFilePath) showImage(path);
+    });
+    connect(m_frames, &QuickLookFrameCache::frameFailed, this, [this](const QString &path) {
+        if (path != m_awaitingFrame || path != currentFilePath) return;
+        m_awaitingFrame.clear();
+        showUnsupported(path, "Unreadable image");
+    });
+
     connect(this, &QDialog::finished, this, [this](int) {
         stopMedia();
+        m_frames->clear();
+        textView->closeFile();
+        pdfView->closeDocument();
     });
 }
 
 void QuickLookDialog::showImage(const QString &path) {
     auto *label = qobject_cast<QLabel*>(stack->widget(0));
-    QImageReader reader(path);
-    reader.setAutoTransform(true);
-    const QImage img = reader.read();
-    if (img.isNull()) { showUnsupported(path, "Unreadable image"); return; }
-
-    // Scale to fit dialog while preserving aspect ratio
-    int availableWidth = width() - 2;
-    int availableHeight = height() - filenameLabel->height() - 2;
+    stack->setCurrentIndex(0);
+    m_awaitingFrame.clear();
+
+    if (!QuickLookFrameCache::canDecode(path)) {
+        // Content says image but the name doesn't (no or odd suffix): decode here.
+        const QImage img = ImageDecoder::decodeScaled(path, imageBound());
+        if (img.isNull()) { showUnsupported(path, "Unreadable image"); return; }
+        QPixmap pixmap = QPixmap::fromImage(img);
+        pixmap.setDevicePixelRatio(devicePixelRatioF());
+        label->setPixmap(pixmap);
+        return;
+    }
 
-    QPixmap pixmap = QPixmap::fromImage(img);
-    if (pixmap.width() > availableWidth || pixmap.height() > availableHeight) {
-        pixmap = pixmap.scaled(availableWidth, availableHeight,
-                              Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // Prefetched frames are already scaled to fit the dialog.
+    const QPixmap ready = m_frames->frame(path, imageBound());
+    if (!ready.isNull()) {
+        label->setPixmap(ready);
+        return;
     }
+    if (m_frames->hasFailed(path)) { showUnsupported(path, "Unreadable image"); return; }
+    // Decoding on the frame cache's pool; frameReady() shows it.
+    label->setPixmap(QPixmap());
+    m_awaitingFrame = path;
+    m_frames->prefetch({path}, {}, imageBound(), devicePixelRatioF());
+}
 
-    label->setPixmap(pixmap);
-    stack->setCurrentIndex(0);
+QSize QuickLookDialog::imageBound() const {
+    const int availableWidth = width() - 2;
+    const int availableHeight = height() - filenameLabel->height() - 2;
+    return QSize(availableWidth, availableHeight) * devicePixelRatioF();
+}
+
+void QuickLookDialog::prefetchNeighbours() {
+    if (!pane || currentFilePath.isEmpty() || !isVisible()) return;
+    // Same order as arrowing: Pane::adjacentFilePath.
+    const QStringList near = {
+        currentFilePath,
+        pane->adjacentFilePath(currentFilePath, +1),
+        pane->adjacentFilePath(currentFilePath, -1),
+    };
+    const QStringList far = {
+        pane->adjacentFilePath(currentFilePath, +2),
+        pane->adjacentFilePath(currentFilePath, -2),
+    };
+    m_frames->prefetch(near, far, imageBound(), devicePixelRatioF());
 }
 
 void QuickLookDialog::showPdf(const QString &path) {
-    std::unique_ptr<Poppler::Document> doc(Poppler::Document::load(path));
-    if (!doc) { showUnsupported(path, "Unreadable PDF"); return; }
-    doc->setRenderHint(Poppler::Document::Antialiasing);
-    doc->setRenderHint(Poppler::Document::TextAntialiasing);
-    std::unique_ptr<Poppler::Page> page(doc->page(0));
-    if (!page) { showUnsupported(path, "Unreadable PDF page"); return; }
-
-    const QImage img = page->renderToImage(150.0, 150.0);
-    if (img.isNull()) { showUnsupported(path, "Failed to render PDF"); return; }
-    auto *scroll = qobject_cast<QScrollArea*>(stack->widget(1));
-    auto *label = qobject_cast<QLabel*>(scroll->widget());
-    label->setPixmap(QPixmap::fromImage(img));
-    label->adjustSize();
+    // Parsed on the view's pool; loadFailed() falls back to the info page.
+    pdfView->open(path);
     stack->setCurrentIndex(1);
+    pdfView->setFocus();
 }
 
 bool QuickLookDialog::showText(const QString &path) {
-    auto *te = qobject_cast<QTextEdit*>(stack->widget(2));
-    QFile f(path);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return false;
-    }
-    // Limit text preview to first 100KB
-    QByteArray rawData = f.read(100 * 1024);
-    if (rawData.contains('\0')) {
+    if (!textView->open(path)) {
         return false;
     }
-    QString text = QString::fromUtf8(rawData);
-    if (!text.isEmpty()) {
-        const int replacementCount = text.count(QChar::ReplacementCharacter);
-        if (replacementCount > (text.size() / 20)) {
-            return false;
-        }
-    }
-    te->setPlainText(text);
     stack->setCurrentIndex(2);
+    textView->setFocus();
     return true;
 }
 
@@ -845,6 +900,8 @@ void QuickLookDialog::showFile(const QString &path) {
     QFileInfo fi(path);
     filenameLabel->setText(fi.fileName().isEmpty() ? path : fi.fileName());
     stopMedia();
+    textView->closeFile();     // drop the previous file's mapping
+    pdfView->closeDocument();  // and its parsed document and tiles
     ++m_directorySizeRequestId;
 
     if (fi.isDir()) {
@@ -893,6 +950,8 @@ void QuickLookDialog::showFile(const QString &path) {
     show();
     raise();
     activateWindow();
+    // After the caller has moved the view's selection to path.
+    QTimer::singleShot(0, this, &QuickLookDialog::prefetchNeighbours);
 }
 
 void QuickLookDialog::navigateNext() {
@@ -13,12 +13,16 @@ class QVideoWidget;
 class QPushButton;
 class QSlider;
 class Pane;
+class QuickLookFrameCache;
+class QuickLookPdfView;
+class QuickLookTextView;
 
 class QuickLookDialog : public QDialog {
     Q_OBJECT
 public:
     explicit QuickLookDialog(Pane *parentPane = nullptr);
     void showFile(const QString &path);
+    QString currentPath() const { return currentFilePath; }
 
 private slots:
     void navigateNext();
@@ -28,6 +32,8 @@ private slots:
 
 private:
     void showImage(const QString &path);
+    QSize imageBound() const;
+    void prefetchNeighbours();
     void showPdf(const QString &path);
     bool showText(const QString &path);
     void showDirectory(const QString &path);
@@ -42,6 +48,10 @@ private:
     QStackedWidget *stack = nullptr;
     QLabel *filenameLabel = nullptr;
     QLabel *unsupportedLabel = nullptr;
+    QuickLookPdfView *pdfView = nullptr;
+    QLabel *pdfStatusLabel = nullptr;
+    QuickLookTextView *textView = nullptr;
+    QLabel *textStatusLabel = nullptr;
     QShortcut *escShortcut = nullptr;
     QShortcut *spaceShortcut = nullptr;
     QShortcut *upShortcut = nullptr;
@@ -78,4 +88,6 @@ private:
     bool activeMediaIsVideo = false;
     bool retriedVideoWithoutAudio = false;
     quint64 m_directorySizeRequestId = 0;
+    QuickLookFrameCache *m_frames = nullptr;
+    QString m_awaitingFrame;  // image on screen whose frame is still decoding
 };
@@ -0,0 +1,130 @@
+#include "QuickLookFrameCache.h"
+#include "ImageDecoder.h"
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+
+// Current file, two either side, and one spare for going back.
+constexpr int MaxFrames = 6;
+
+}
+
+QuickLookFrameCache::QuickLookFrameCache(QObject *parent) : QObject(parent) {
+    m_pool.setMaxThreadCount(2);
+}
+
+QuickLookFrameCache::~QuickLookFrameCache() {
+    m_near.clear();
+    m_far.clear();
+    m_pool.waitForDone();
+}
+
+bool QuickLookFrameCache::canDecode(const QString &path) {
+    if (ImageDecoder::isRawFile(path)) return true;
+    static const QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return !suffix.isEmpty() && formats.contains(suffix.toLatin1());
+}
+
+QPixmap QuickLookFrameCache::frame(const QString &path, const QSize &bound) {
+    const auto it = m_frames.constFind(path);
+    if (it == m_frames.cend() || it->bound != bound) return QPixmap();
+    const QFileInfo fi(path);
+    if (fi.lastModified() != it->modified || fi.size() != it->size) {
+        m_frames.erase(it);
+        m_recent.removeOne(path);
+        return QPixmap();
+    }
+    m_recent.removeOne(path);
+    m_recent.append(path);
+    return it->pixmap;
+}
+
+void QuickLookFrameCache::prefetch(const QStringList &near, const QStringList &far, const QSize &bound, qreal dpr) {
+    if (bound != m_bound || dpr != m_dpr) {
+        // Frames for another dialog size would be rescaled; make new ones.
+        m_frames.clear();
+        m_recent.clear();
+        m_bound = bound;
+        m_dpr = dpr;
+    }
+    const auto wanted = [this](const QStringList &paths) {
+        QStringList queue;
+        for (const QString &path : paths) {
+            if (path.isEmpty() || !canDecode(path) || m_failed.contains(path) || m_running.contains(path)) continue;
+            if (!frame(path, m_bound).isNull()) continue;
+            queue.append(path);
+        }
+        return queue;
+    };
+    m_wantedNear = near;
+    m_wantedFar = far;
+    m_near = wanted(near);
+    m_far = wanted(far);
+    dispatch();
+}
+
+void QuickLookFrameCache::clear() {
+    m_near.clear();
+    m_far.clear();
+    m_wantedNear.clear();
+    m_wantedFar.clear();
+    m_frames.clear();
+    m_recent.clear();
+    m_failed.clear();
+}
+
+QuickLookFrameCache::Decoded QuickLookFrameCache::decode(const QString &path, const QSize &bound) {
+    const QFileInfo fi(path);
+    Decoded decoded;
+    decoded.modified = fi.lastModified();
+    decoded.size = fi.size();
+    decoded.image = ImageDecoder::decodeScaled(path, bound);
+    return decoded;
+}
+
+void QuickLookFrameCache::dispatch() {
+    while (m_running.size() < m_pool.maxThreadCount()) {
+        // Far neighbours only once everything near is decoded.
+        QStringList &queue = !m_near.isEmpty() ? m_near : m_far;
+        if (queue.isEmpty() || (&queue == &m_far && !m_running.isEmpty())) return;
+        const QString path = queue.takeFirst();
+        m_running.insert(path);
+
+        const QSize bound = m_bound;
+        const qreal dpr = m_dpr;
+        auto *watcher = new QFutureWatcher<Decoded>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, path, bound, dpr]() {
+            watcher->deleteLater();
+            finish(path, bound, dpr, watcher->result());
+        });
+        watcher->setFuture(QtConcurrent::run(&m_pool, &QuickLookFrameCache::decode, path, bound));
+    }
+}
+
+void QuickLookFrameCache::finish(const QString &path, const QSize &bound, qreal dpr, const Decoded &decoded) {
+    m_running.remove(path);
+    if (decoded.image.isNull()) {
+        m_failed.insert(path);
+        emit frameFailed(path);
+    } else if (bound == m_bound && dpr == m_dpr) {
+        // Converted here, off the keypress path, so showing it is a setPixmap.
+        QPixmap pixmap = QPixmap::fromImage(decoded.image);
+        pixmap.setDevicePixelRatio(dpr);
+        m_frames.insert(path, {pixmap, bound, decoded.modified, decoded.size});
+        m_recent.removeOne(path);
+        m_recent.append(path);
+        while (m_recent.size() > MaxFrames) m_frames.remove(m_recent.takeFirst());
+        emit frameReady(path);
+    } else if (m_wantedNear.contains(path)) {
+        // Decoded for a size the dialog no longer has (first layout, resize,
+        // another screen); prefetch() skipped it while it ran.
+        m_near.prepend(path);
+    } else if (m_wantedFar.contains(path)) {
+        m_far.append(path);
+    }
+    dispatch();
+}
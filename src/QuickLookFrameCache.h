@@ -0,0 +1,67 @@
+#pragma once
+#include <QDateTime>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+#include <QStringList>
+#include <QThreadPool>
+
+// Quick Look's decoded frames: images already scaled to the dialog and
+// converted to pixmaps, for the file on screen and its neighbours. Decodes
+// run on a small pool, so arrowing to a prefetched file paints at once and
+// a miss never blocks the keypress. Holds a handful of frames, least
+// recently used dropped first.
+class QuickLookFrameCache : public QObject {
+    Q_OBJECT
+public:
+    explicit QuickLookFrameCache(QObject *parent = nullptr);
+    ~QuickLookFrameCache() override;
+
+    // Cheap, name-based check for files this cache can decode.
+    static bool canDecode(const QString &path);
+
+    // Frame for this version of path at bound (device pixels), or null.
+    QPixmap frame(const QString &path, const QSize &bound);
+    bool hasFailed(const QString &path) const { return m_failed.contains(path); }
+
+    // Decodes near (most important first), then far once near is done.
+    // Queued decodes for anything not listed are dropped.
+    void prefetch(const QStringList &near, const QStringList &far, const QSize &bound, qreal dpr);
+    void clear();
+
+signals:
+    void frameReady(const QString &path);
+    void frameFailed(const QString &path);
+
+private:
+    struct Frame {
+        QPixmap pixmap;
+        QSize bound;
+        QDateTime modified;
+        qint64 size = -1;
+    };
+    struct Decoded {
+        QImage image;
+        QDateTime modified;
+        qint64 size = -1;
+    };
+
+    static Decoded decode(const QString &path, const QSize &bound);
+    void dispatch();
+    void finish(const QString &path, const QSize &bound, qreal dpr, const Decoded &decoded);
+
+    QThreadPool m_pool;
+    QHash<QString, Frame> m_frames;
+    QStringList m_recent;  // least recently used first
+    QStringList m_near;    // queued
+    QStringList m_far;
+    QStringList m_wantedNear;  // as last passed to prefetch(), queued or not
+    QStringList m_wantedFar;
+    QSet<QString> m_running;
+    QSet<QString> m_failed;
+    QSize m_bound;
+    qreal m_dpr = 1.0;
+};
@@ -0,0 +1,385 @@
+#include "QuickLookPdfView.h"
+#include <QFutureWatcher>
+#include <QKeyEvent>
+#include <QMutex>
+#include <QPainter>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <QtConcurrent/QtConcurrentRun>
+#include <poppler-qt6.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+constexpr int Margin = 12;         // around and between pages
+constexpr int TileSize = 512;      // device pixels
+constexpr int MinPageWidth = 120;  // logical pixels
+constexpr qreal MinZoom = 0.25;
+constexpr qreal MaxZoom = 6.0;
+constexpr qreal ZoomStep = 1.25;
+// Rendered tiles kept, in KB (QCache cost).
+constexpr int MaxTileKBytes = 192 * 1024;
+
+}
+
+// Parsed copies of one PDF, one per render thread: Poppler documents must
+// not be rendered from two threads at once, and reparsing per tile would
+// cost more than the render. Copies are made on demand and reused until
+// the view closes the file.
+class QuickLookPdfView::DocumentPool {
+public:
+    explicit DocumentPool(const QString &path) : m_path(path) {}
+
+    std::unique_ptr<Poppler::Document> take() {
+        if (m_closed) return nullptr;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (!m_idle.empty()) {
+                std::unique_ptr<Poppler::Document> doc = std::move(m_idle.back());
+                m_idle.pop_back();
+                return doc;
+            }
+        }
+        std::unique_ptr<Poppler::Document> doc(Poppler::Document::load(m_path));
+        if (!doc || doc->isLocked()) return nullptr;
+        doc->setRenderHint(Poppler::Document::Antialiasing);
+        doc->setRenderHint(Poppler::Document::TextAntialiasing);
+        return doc;
+    }
+
+    void give(std::unique_ptr<Poppler::Document> doc) {
+        if (!doc || m_closed) return;
+        QMutexLocker lock(&m_mutex);
+        m_idle.push_back(std::move(doc));
+    }
+
+    // Queued renders for a closed file return at once.
+    void close() {
+        m_closed = true;
+        QMutexLocker lock(&m_mutex);
+        m_idle.clear();
+    }
+
+private:
+    const QString m_path;
+    QMutex m_mutex;
+    std::vector<std::unique_ptr<Poppler::Document>> m_idle;
+    std::atomic<bool> m_closed = false;
+};
+
+QuickLookPdfView::QuickLookPdfView(QWidget *parent) : QAbstractScrollArea(parent) {
+    m_pool.setMaxThreadCount(2);
+    m_tiles.setMaxCost(MaxTileKBytes);
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setAutoFillBackground(false);
+    verticalScrollBar()->setSingleStep(40);
+    horizontalScrollBar()->setSingleStep(40);
+}
+
+QuickLookPdfView::~QuickLookPdfView() {
+    blockSignals(true);
+    closeDocument();
+    m_pool.waitForDone();
+}
+
+void QuickLookPdfView::open(const QString &path) {
+    closeDocument();
+    m_documents = std::make_shared<DocumentPool>(path);
+    const quint64 generation = m_generation;
+    auto *watcher = new QFutureWatcher<Layout>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation, path]() {
+        watcher->deleteLater();
+        --m_inFlight;
+        if (generation != m_generation) {
+            dispatch();
+            return;
+        }
+        const Layout layout = watcher->result();
+        if (!layout.ok) {
+            emit loadFailed(path);
+            return;
+        }
+        applyLayout(layout);
+    });
+    ++m_inFlight;
+    watcher->setFuture(QtConcurrent::run(&m_pool, &QuickLookPdfView::load, m_documents));
+}
+
+void QuickLookPdfView::closeDocument() {
+    ++m_generation;
+    if (m_documents) m_documents->close();
+    m_documents.reset();
+    m_queue.clear();
+    m_running.clear();
+    m_tiles.clear();
+    m_pageSizes.clear();
+    m_zoom = 1.0;
+    relayout();
+    // No pages until the next layout lands; the status shows it opening.
+    emit positionChanged();
+}
+
+QuickLookPdfView::Layout QuickLookPdfView::load(std::shared_ptr<DocumentPool> pool) {
+    Layout layout;
+    std::unique_ptr<Poppler::Document> doc = pool->take();
+    if (!doc || doc->numPages() <= 0) return layout;
+    // Sizes only: nothing is rendered until a page scrolls into view.
+    const int pages = doc->numPages();
+    layout.pageSizes.reserve(pages);
+    for (int i = 0; i < pages; ++i) {
+        std::unique_ptr<Poppler::Page> page(doc->page(i));
+        const QSizeF size = page ? page->pageSizeF() : QSizeF();
+        layout.pageSizes.append(size.isEmpty() ? QSizeF(612, 792) : size);
+    }
+    pool->give(std::move(doc));
+    layout.ok = true;
+    return layout;
+}
+
+QImage QuickLookPdfView::renderTile(std::shared_ptr<DocumentPool> pool, TileKey key, QRect rect, double dpi) {
+    std::unique_ptr<Poppler::Document> doc = pool->take();
+    if (!doc) return QImage();
+    QImage image;
+    if (std::unique_ptr<Poppler::Page> page(doc->page(key.page)); page) {
+        image = page->renderToImage(dpi, dpi, rect.x(), rect.y(), rect.width(), rect.height());
+    }
+    pool->give(std::move(doc));
+    return image;
+}
+
+void QuickLookPdfView::applyLayout(const Layout &layout) {
+    m_pageSizes = layout.pageSizes;
+    relayout();
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    requestTiles();
+    emit loaded();
+    emit positionChanged();
+}
+
+int QuickLookPdfView::currentPage() const {
+    if (m_pageTops.isEmpty()) return 0;
+    const int centre = verticalScrollBar()->value() + viewport()->height() / 2;
+    const auto it = std::upper_bound(m_pageTops.cbegin(), m_pageTops.cend(), centre);
+    return qMax(0, int(it - m_pageTops.cbegin()) - 1);
+}
+
+void QuickLookPdfView::setZoom(qreal zoom) {
+    zoom = qBound(MinZoom, zoom, MaxZoom);
+    if (qFuzzyCompare(zoom, m_zoom)) return;
+    m_zoom = zoom;
+    relayout();
+    requestTiles();
+    emit positionChanged();
+}
+
+void QuickLookPdfView::relayout() {
+    // Keep the point at the viewport's centre where it is in the document.
+    const int viewHeight = viewport()->height();
+    const qreal anchor = m_contentHeight > 0
+        ? qreal(verticalScrollBar()->value() + viewHeight / 2) / m_contentHeight : 0.0;
+
+    const int width = pageWidth();
+    m_pageTops.resize(m_pageSizes.size());
+    int y = Margin;
+    for (int i = 0; i < m_pageSizes.size(); ++i) {
+        m_pageTops[i] = y;
+        const QSizeF &size = m_pageSizes.at(i);
+        y += qRound(width * size.height() / size.width()) + Margin;
+    }
+    m_contentHeight = m_pageSizes.isEmpty() ? 0 : y;
+
+    updateScrollBars();
+    verticalScrollBar()->setValue(qRound(anchor * m_contentHeight) - viewHeight / 2);
+    viewport()->update();
+}
+
+void QuickLookPdfView::updateScrollBars() {
+    const QSize view = viewport()->size();
+    const int contentWidth = m_pageSizes.isEmpty() ? 0 : pageWidth() + 2 * Margin;
+    verticalScrollBar()->setRange(0, qMax(0, m_contentHeight - view.height()));
+    verticalScrollBar()->setPageStep(view.height());
+    horizontalScrollBar()->setRange(0, qMax(0, contentWidth - view.width()));
+    horizontalScrollBar()->setPageStep(view.width());
+}
+
+int QuickLookPdfView::pageWidth() const {
+    return qMax(MinPageWidth, qRound((viewport()->width() - 2 * Margin) * m_zoom));
+}
+
+QRect QuickLookPdfView::pageRect(int page) const {
+    const int width = pageWidth();
+    const QSizeF &size = m_pageSizes.at(page);
+    // Narrow pages are centred; wider ones scroll horizontally.
+    const int x = qMax(Margin, (viewport()->width() - width) / 2);
+    return QRect(x, m_pageTops.at(page), width, qRound(width * size.height() / size.width()));
+}
+
+QSize QuickLookPdfView::tileGrid(int page, int deviceWidth) const {
+    const QSizeF &size = m_pageSizes.at(page);
+    const int deviceHeight = qRound(deviceWidth * size.height() / size.width());
+    return QSize((deviceWidth + TileSize - 1) / TileSize, (deviceHeight + TileSize - 1) / TileSize);
+}
+
+QRect QuickLookPdfView::tileRect(const TileKey &key) const {
+    const QSizeF &size = m_pageSizes.at(key.page);
+    const int deviceHeight = qRound(key.width * size.height() / size.width());
+    const QRect tile(key.column * TileSize, key.row * TileSize, TileSize, TileSize);
+    return tile.intersected(QRect(0, 0, key.width, deviceHeight));
+}
+
+void QuickLookPdfView::requestTiles() {
+    m_queue.clear();
+    if (m_pageSizes.isEmpty() || !m_documents) return;
+
+    const QPoint scroll(horizontalScrollBar()->value(), verticalScrollBar()->value());
+    const QRect visible(scroll, viewport()->size());
+    // Lookahead: a screen below (the usual direction) and half a screen above.
+    const QRect ahead = visible.adjusted(0, -visible.height() / 2, 0, visible.height());
+    const qreal dpr = devicePixelRatioF();
+    const int deviceWidth = qRound(pageWidth() * dpr);
+
+    QVector<TileKey> later;
+    const auto first = std::upper_bound(m_pageTops.cbegin(), m_pageTops.cend(), ahead.top());
+    for (int page = qMax(0, int(first - m_pageTops.cbegin()) - 1);
+         page < m_pageSizes.size() && m_pageTops.at(page) < ahead.bottom(); ++page) {
+        const QRect rect = pageRect(page);
+        const QSize grid = tileGrid(page, deviceWidth);
+        const int columns = grid.width();
+        const int rows = grid.height();
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                const TileKey key{page, deviceWidth, column, row};
+                if (m_tiles.contains(key) || m_running.contains(key)) continue;
+                const QRectF tile = tileRect(key);
+                const QRect area = QRectF(rect.topLeft() + tile.topLeft() / dpr, tile.size() / dpr).toAlignedRect();
+                if (area.intersects(visible)) m_queue.append(key);
+                else if (area.intersects(ahead)) later.append(key);
+            }
+        }
+    }
+    m_queue += later;
+    dispatch();
+}
+
+void QuickLookPdfView::dispatch() {
+    // Jobs of a closed file keep their pool thread until they return, so the
+    // limit counts everything in flight, not only this generation's tiles.
+    while (m_inFlight < m_pool.maxThreadCount() && !m_queue.isEmpty()) {
+        const TileKey key = m_queue.takeFirst();
+        m_running.insert(key);
+        ++m_inFlight;
+
+        const quint64 generation = m_generation;
+        const QRect rect = tileRect(key);
+        const double dpi = 72.0 * key.width / m_pageSizes.at(key.page).width();
+        auto *watcher = new QFutureWatcher<QImage>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, key, generation]() {
+            watcher->deleteLater();
+            finishTile(key, generation, watcher->result());
+        });
+        watcher->setFuture(QtConcurrent::run(&m_pool, &QuickLookPdfView::renderTile, m_documents, key, rect, dpi));
+    }
+}
+
+void QuickLookPdfView::finishTile(const TileKey &key, quint64 generation, const QImage &image) {
+    --m_inFlight;
+    if (generation != m_generation) {  // another file by now
+        dispatch();
+        return;
+    }
+    m_running.remove(key);
+    if (!image.isNull()) {
+        const int cost = qMax<qsizetype>(1, image.sizeInBytes() / 1024);
+        m_tiles.insert(key, new QPixmap(QPixmap::fromImage(image)), cost);
+        if (key.width == qRound(pageWidth() * devicePixelRatioF())) viewport()->update();
+    }
+    dispatch();
+}
+
+void QuickLookPdfView::paintEvent(QPaintEvent *) {
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), QColor(0x1f, 0x21, 0x27));
+    if (m_pageSizes.isEmpty()) return;
+
+    const QPoint scroll(horizontalScrollBar()->value(), verticalScrollBar()->value());
+    const QRect visible(scroll, viewport()->size());
+    const qreal dpr = devicePixelRatioF();
+    const int deviceWidth = qRound(pageWidth() * dpr);
+    painter.translate(-scroll);
+    painter.setPen(QColor(0x9a, 0xa3, 0xb2));
+
+    const auto first = std::upper_bound(m_pageTops.cbegin(), m_pageTops.cend(), visible.top());
+    for (int page = qMax(0, int(first - m_pageTops.cbegin()) - 1);
+         page < m_pageSizes.size() && m_pageTops.at(page) < visible.bottom(); ++page) {
+        const QRect rect = pageRect(page);
+        painter.fillRect(rect, Qt::white);
+        // Shown until the page's tiles are in.
+        painter.drawText(rect, Qt::AlignCenter, QString::number(page + 1));
+
+        const QSize grid = tileGrid(page, deviceWidth);
+        const int columns = grid.width();
+        const int rows = grid.height();
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                const QPixmap *tile = m_tiles.object({page, deviceWidth, column, row});
+                if (!tile) continue;
+                const QRectF source = tileRect({page, deviceWidth, column, row});
+                const QRectF target(rect.topLeft() + source.topLeft() / dpr, source.size() / dpr);
+                if (target.intersects(visible)) painter.drawPixmap(target, *tile, QRectF(tile->rect()));
+            }
+        }
+    }
+}
+
+void QuickLookPdfView::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    // Pages follow the width, so tiles for the old width are stale.
+    relayout();
+    requestTiles();
+    emit positionChanged();
+}
+
+void QuickLookPdfView::scrollContentsBy(int, int) {
+    viewport()->update();
+    requestTiles();
+    emit positionChanged();
+}
+
+void QuickLookPdfView::wheelEvent(QWheelEvent *event) {
+    if (event->modifiers() & Qt::ControlModifier) {
+        const int delta = event->angleDelta().y();
+        if (delta != 0) setZoom(delta > 0 ? m_zoom * ZoomStep : m_zoom / ZoomStep);
+        event->accept();
+        return;
+    }
+    QAbstractScrollArea::wheelEvent(event);
+}
+
+void QuickLookPdfView::keyPressEvent(QKeyEvent *event) {
+    if (event->modifiers() & Qt::ControlModifier) {
+        switch (event->key()) {
+        case Qt::Key_Plus:
+        case Qt::Key_Equal:
+            setZoom(m_zoom * ZoomStep);
+            return;
+        case Qt::Key_Minus:
+            setZoom(m_zoom / ZoomStep);
+            return;
+        case Qt::Key_0:
+            setZoom(1.0);
+            return;
+        case Qt::Key_Home:
+            verticalScrollBar()->setValue(0);
+            return;
+        case Qt::Key_End:
+            verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+            return;
+        default:
+            break;
+        }
+    }
+    QAbstractScrollArea::keyPressEvent(event);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <QAbstractScrollArea>
+#include <QCache>
+#include <QHash>
+#include <QPixmap>
+#include <QSet>
+#include <QSizeF>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+
+// Scrollable multi-page PDF viewer. The document is parsed once on open
+// and kept for as long as it is shown; pages are laid out from their sizes
+// alone and rendered lazily as tiles on a small pool, only for what is in
+// view plus a little lookahead. Tiles are rendered at the current zoom and
+// device pixel ratio and kept in a cache bounded by bytes.
+// Ctrl+wheel or Ctrl+=/Ctrl+- zoom, Ctrl+0 fits the width again.
+class QuickLookPdfView : public QAbstractScrollArea {
+    Q_OBJECT
+public:
+    struct Layout {
+        QVector<QSizeF> pageSizes;  // points
+        bool ok = false;
+    };
+
+    explicit QuickLookPdfView(QWidget *parent = nullptr);
+    ~QuickLookPdfView() override;
+
+    // Parses path on the pool; loaded() or loadFailed() follows.
+    void open(const QString &path);
+    void closeDocument();
+
+    int pageCount() const { return m_pageSizes.size(); }
+    int currentPage() const;  // 0-based, page at the viewport's centre
+    qreal zoom() const { return m_zoom; }
+    void setZoom(qreal zoom);
+
+signals:
+    void loaded();
+    void loadFailed(const QString &path);
+    // Scroll position, zoom or page count changed.
+    void positionChanged();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    class DocumentPool;
+
+    struct TileKey {
+        int page = 0;
+        int width = 0;   // page width in device pixels; identifies the zoom
+        int column = 0;
+        int row = 0;
+        bool operator==(const TileKey &other) const {
+            return page == other.page && width == other.width && column == other.column && row == other.row;
+        }
+    };
+    friend size_t qHash(const TileKey &key, size_t seed) {
+        return qHashMulti(seed, key.page, key.width, key.column, key.row);
+    }
+
+    static Layout load(std::shared_ptr<DocumentPool> pool);
+    static QImage renderTile(std::shared_ptr<DocumentPool> pool, TileKey key, QRect rect, double dpi);
+
+    void applyLayout(const Layout &layout);
+    void relayout();
+    void updateScrollBars();
+    int pageWidth() const;  // logical pixels
+    QRect pageRect(int page) const;  // content coordinates
+    QSize tileGrid(int page, int deviceWidth) const;  // columns x rows
+    QRect tileRect(const TileKey &key) const;  // device pixels within the page
+    void requestTiles();
+    void dispatch();
+    void finishTile(const TileKey &key, quint64 generation, const QImage &image);
+
+    std::shared_ptr<DocumentPool> m_documents;
+    QThreadPool m_pool;
+    QVector<QSizeF> m_pageSizes;
+    QVector<int> m_pageTops;  // content y of each page, logical pixels
+    int m_contentHeight = 0;
+    qreal m_zoom = 1.0;  // 1.0 fits the page width to the viewport
+    quint64 m_generation = 0;  // bumped on open/close; stale results are dropped
+    QCache<TileKey, QPixmap> m_tiles;
+    QVector<TileKey> m_queue;  // wanted tiles, most important first
+    QSet<TileKey> m_running;  // this generation's tiles, to skip duplicates
+    int m_inFlight = 0;  // jobs on m_pool of any generation
+};
@@ -0,0 +1,268 @@
+#include "QuickLookTextView.h"
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QInputDialog>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <cstring>
+#include <limits>
+#include <sys/stat.h>
+
+namespace {
+
+// Bytes scanned between progress reports.
+constexpr qint64 IndexChunk = 8ll * 1024 * 1024;
+// Sample checked for binary content, as the old 100 KB preview did.
+constexpr qint64 SniffBytes = 100 * 1024;
+// Longer lines are cut when painted (minified JSON, base64 blobs).
+constexpr qint64 MaxPaintedLineBytes = 16 * 1024;
+constexpr int Margin = 10;
+
+bool looksBinary(const uchar *data, qint64 size) {
+    const qint64 sample = qMin(size, SniffBytes);
+    if (memchr(data, '\0', sample)) return true;
+    const QString text = QString::fromUtf8(reinterpret_cast<const char*>(data), sample);
+    return text.count(QChar::ReplacementCharacter) > text.size() / 20;
+}
+
+}
+
+QuickLookTextView::QuickLookTextView(QWidget *parent) : QAbstractScrollArea(parent) {
+    QFont mono(QStringLiteral("monospace"));
+    mono.setStyleHint(QFont::Monospace);
+    mono.setPixelSize(13);
+    setFont(mono);
+    setFocusPolicy(Qt::StrongFocus);
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &QuickLookTextView::checkFile);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        m_followEnd = m_followEnd && value == verticalScrollBar()->maximum();
+        emit positionChanged();
+    });
+}
+
+void QuickLookTextView::checkFile() {
+    // m_file.size() is the mapped inode's size: a log rotated by rename
+    // keeps the old file intact, copytruncate shrinks it under us.
+    if (!m_data || m_file.size() >= m_size) return;
+    const QString path = m_file.fileName();
+    const int value = verticalScrollBar()->value();
+    const bool atEnd = value == verticalScrollBar()->maximum();
+    if (!open(path)) {
+        closeFile();
+        viewport()->update();
+        emit positionChanged();
+        return;
+    }
+    if (atEnd) goToEnd();
+    else verticalScrollBar()->setValue(value);
+}
+
+QuickLookTextView::~QuickLookTextView() {
+    closeFile();
+}
+
+bool QuickLookTextView::open(const QString &path) {
+    closeFile();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+    m_size = m_file.size();
+    if (m_size > 0) {
+        m_data = m_file.map(0, m_size);
+        if (!m_data || looksBinary(m_data, m_size)) {
+            closeFile();
+            return false;
+        }
+    }
+
+    m_checkpoints = {0};
+    m_lines = m_size > 0 ? 1 : 0;
+    m_indexDone = m_size == 0;
+    if (!m_indexDone) {
+        m_indexWatcher = new QFutureWatcher<IndexProgress>(this);
+        connect(m_indexWatcher, &QFutureWatcherBase::resultsReadyAt, this, &QuickLookTextView::applyProgress);
+        m_index = QtConcurrent::run(&QuickLookTextView::index, m_file.handle(), m_data, m_size);
+        m_indexWatcher->setFuture(m_index);
+    }
+    m_watcher->addPath(path);
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    updateScrollBars();
+    viewport()->update();
+    emit positionChanged();
+    return true;
+}
+
+void QuickLookTextView::closeFile() {
+    if (m_indexWatcher) {
+        // The worker reads the mapping; it has to stop before the unmap.
+        m_index.cancel();
+        m_index.waitForFinished();
+        delete m_indexWatcher;
+        m_indexWatcher = nullptr;
+    }
+    m_index = QFuture<IndexProgress>();
+    if (!m_watcher->files().isEmpty()) m_watcher->removePaths(m_watcher->files());
+    if (m_data) m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_file.close();
+    m_size = 0;
+    m_checkpoints.clear();
+    m_lines = 0;
+    m_longestLine = 0;
+    m_indexDone = true;
+    m_followEnd = false;
+}
+
+void QuickLookTextView::index(QPromise<IndexProgress> &promise, int fd, const uchar *data, qint64 size) {
+    qint64 lines = 0;  // newlines seen
+    qint64 lineStartPos = 0;
+    qint64 longest = 0;
+    for (qint64 chunk = 0; chunk < size; chunk += IndexChunk) {
+        if (promise.isCanceled()) return;
+        IndexProgress progress;
+        const qint64 chunkEnd = qMin(size, chunk + IndexChunk);
+        // Truncated meanwhile: stop short of the SIGBUS; the view reopens it.
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < chunkEnd) return;
+        const uchar *pos = data + chunk;
+        while (const void *found = memchr(pos, '\n', chunkEnd - (pos - data))) {
+            const qint64 newline = static_cast<const uchar*>(found) - data;
+            longest = qMax(longest, newline - lineStartPos);
+            lineStartPos = newline + 1;
+            ++lines;
+            if (lines % LineStride == 0 && lineStartPos < size) progress.checkpoints.append(lineStartPos);
+            pos = data + lineStartPos;
+        }
+        const bool done = chunkEnd == size;
+        if (done) longest = qMax(longest, size - lineStartPos);
+        // A last line without a trailing newline still counts.
+        progress.lines = lines + (lineStartPos < chunkEnd ? 1 : 0);
+        progress.longestLine = longest;
+        progress.done = done;
+        promise.addResult(progress);
+    }
+}
+
+void QuickLookTextView::applyProgress(int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        const IndexProgress progress = m_indexWatcher->resultAt(i);
+        m_checkpoints += progress.checkpoints;
+        m_lines = progress.lines;
+        m_longestLine = progress.longestLine;
+        m_indexDone = progress.done;
+    }
+    updateScrollBars();
+    if (m_followEnd) verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    m_followEnd = m_followEnd && !m_indexDone;
+    viewport()->update();
+    emit positionChanged();
+}
+
+void QuickLookTextView::updateScrollBars() {
+    const int rows = visibleLineCount();
+    const qint64 maxFirst = qMax<qint64>(0, m_lines - rows + 1);
+    verticalScrollBar()->setRange(0, int(qMin<qint64>(maxFirst, std::numeric_limits<int>::max())));
+    verticalScrollBar()->setPageStep(qMax(1, rows - 1));
+    verticalScrollBar()->setSingleStep(1);
+
+    const int charWidth = fontMetrics().horizontalAdvance(QLatin1Char('M'));
+    const qint64 contentWidth = qMin(m_longestLine, MaxPaintedLineBytes) * charWidth + 2 * Margin;
+    horizontalScrollBar()->setRange(0, int(qMax<qint64>(0, contentWidth - viewport()->width())));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(charWidth * 4);
+}
+
+qint64 QuickLookTextView::firstVisibleLine() const {
+    return verticalScrollBar()->value();
+}
+
+int QuickLookTextView::visibleLineCount() const {
+    return qMax(1, viewport()->height() / fontMetrics().lineSpacing());
+}
+
+qint64 QuickLookTextView::lineStart(qint64 line) const {
+    const qint64 checkpoint = qMin<qint64>(line / LineStride, m_checkpoints.size() - 1);
+    qint64 pos = m_checkpoints.value(checkpoint);
+    // At most LineStride - 1 lines to skip (more while the index catches up).
+    for (qint64 skip = line - checkpoint * LineStride; skip > 0 && pos < m_size; --skip) {
+        pos = lineEnd(pos) + 1;
+    }
+    return pos;
+}
+
+qint64 QuickLookTextView::lineEnd(qint64 start) const {
+    const void *found = memchr(m_data + start, '\n', m_size - start);
+    return found ? static_cast<const uchar*>(found) - m_data : m_size;
+}
+
+void QuickLookTextView::paintEvent(QPaintEvent *) {
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), QColor(0x1f, 0x21, 0x27));
+    if (!m_data) return;
+    // Reading a mapping past a truncated end raises SIGBUS; the watcher
+    // can lag, so check the open file itself before touching it.
+    if (m_file.size() < m_size) {
+        QTimer::singleShot(0, this, &QuickLookTextView::checkFile);
+        return;
+    }
+    painter.setPen(QColor(0xe5, 0xe8, 0xed));
+
+    const QFontMetrics metrics = fontMetrics();
+    const int lineHeight = metrics.lineSpacing();
+    const int x = Margin - horizontalScrollBar()->value();
+    const qint64 first = firstVisibleLine();
+    const int rows = visibleLineCount() + 1;
+    qint64 pos = lineStart(first);
+    for (int row = 0; row < rows && first + row < m_lines && pos < m_size; ++row) {
+        const qint64 end = lineEnd(pos);
+        qint64 length = qMin(end - pos, MaxPaintedLineBytes);
+        if (length > 0 && m_data[pos + length - 1] == '\r') --length;
+        QString text = QString::fromUtf8(reinterpret_cast<const char*>(m_data + pos), length);
+        text.replace(QLatin1Char('\t'), QStringLiteral("    "));
+        painter.drawText(x, row * lineHeight + metrics.ascent(), text);
+        pos = end + 1;
+    }
+}
+
+void QuickLookTextView::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+    emit positionChanged();
+}
+
+void QuickLookTextView::keyPressEvent(QKeyEvent *event) {
+    if (event->modifiers() & Qt::ControlModifier) {
+        switch (event->key()) {
+        case Qt::Key_Home: goToLine(1); return;
+        case Qt::Key_End: goToEnd(); return;
+        case Qt::Key_G: promptGoToLine(); return;
+        default: break;
+        }
+    }
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void QuickLookTextView::goToLine(qint64 line) {
+    m_followEnd = false;
+    verticalScrollBar()->setValue(int(qBound<qint64>(0, line - 1, verticalScrollBar()->maximum())));
+}
+
+void QuickLookTextView::goToEnd() {
+    verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    // Lines still being indexed keep arriving below; stay with them.
+    m_followEnd = !m_indexDone;
+}
+
+void QuickLookTextView::promptGoToLine() {
+    if (m_lines <= 0) return;
+    bool ok = false;
+    const QString label = m_indexDone ? tr("Line (1–%1):").arg(m_lines)
+                                      : tr("Line (1–%1, still counting):").arg(m_lines);
+    const int line = QInputDialog::getInt(this, tr("Go to Line"), label, int(firstVisibleLine() + 1), 1,
+                                          int(qMin<qint64>(m_lines, std::numeric_limits<int>::max())), 1, &ok);
+    if (ok) goToLine(line);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <QAbstractScrollArea>
+#include <QFile>
+#include <QFuture>
+#include <QPromise>
+#include <QVector>
+
+class QFileSystemWatcher;
+template <typename T> class QFutureWatcher;
+
+// Read-only viewer for text files of any size. The file is memory-mapped,
+// a worker indexes line starts in chunks (every LineStride-th line, so the
+// index stays small for multi-GB logs) and only the lines in the viewport
+// are decoded and painted. Scrolling works while indexing is still going.
+// Ctrl+G jumps to a line, Ctrl+Home/Ctrl+End to either end of the file.
+// A file truncated while shown (copytruncate log rotation) is reopened.
+class QuickLookTextView : public QAbstractScrollArea {
+    Q_OBJECT
+public:
+    struct IndexProgress {
+        QVector<qint64> checkpoints;  // starts of lines k*LineStride, continuing the previous batch
+        qint64 lines = 0;             // lines seen so far
+        qint64 longestLine = 0;       // bytes
+        bool done = false;
+    };
+
+    static constexpr int LineStride = 256;
+
+    explicit QuickLookTextView(QWidget *parent = nullptr);
+    ~QuickLookTextView() override;
+
+    // Maps path and starts indexing; false if it cannot be mapped or looks
+    // binary (NUL bytes or mostly invalid UTF-8 near the start).
+    bool open(const QString &path);
+    void closeFile();
+
+    qint64 lineCount() const { return m_lines; }
+    bool isIndexing() const { return !m_indexDone; }
+    qint64 firstVisibleLine() const;
+    int visibleLineCount() const;
+
+    void goToLine(qint64 line);  // 1-based
+    void goToEnd();
+    void promptGoToLine();
+
+signals:
+    // Scroll position or line count changed.
+    void positionChanged();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    static void index(QPromise<IndexProgress> &promise, int fd, const uchar *data, qint64 size);
+    // Reopens the file if it shrank (copytruncate), before the mapping is read past its end.
+    void checkFile();
+    void applyProgress(int begin, int end);
+    void updateScrollBars();
+    qint64 lineStart(qint64 line) const;
+    qint64 lineEnd(qint64 start) const;
+
+    QFile m_file;
+    QFileSystemWatcher *m_watcher = nullptr;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    QFuture<IndexProgress> m_index;
+    QFutureWatcher<IndexProgress> *m_indexWatcher = nullptr;
+    QVector<qint64> m_checkpoints;
+    qint64 m_lines = 0;
+    qint64 m_longestLine = 0;
+    bool m_indexDone = true;
+    bool m_followEnd = false;  // keep the end in view while the index grows
+};
@@ -1,5 +1,7 @@
 #include "SettingsDialog.h"
 #include "MainWindow.h"
+#include "ThumbCache.h"
+#include "ThumbnailMaintenance.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
@@ -147,6 +149,20 @@ void SettingsDialog::setupViewTab() {
     m_showThumbnails = new QCheckBox(tr("Show thumbnails for images"));
     m_showThumbnails->setToolTip(tr("Display thumbnail previews for image files"));
     iconLayout->addWidget(m_showThumbnails, 1, 0, 1, 4);
+
+    iconLayout->addWidget(new QLabel(tr("Thumbnail memory:")), 2, 0);
+    m_thumbnailCacheMB = new QSpinBox;
+    m_thumbnailCacheMB->setRange(16, 4096);
+    m_thumbnailCacheMB->setSuffix(" MB");
+    m_thumbnailCacheMB->setToolTip(tr("Memory shared by all tabs for thumbnails: a quarter keeps them decoded, the rest holds them compressed; least used ones are dropped first"));
+    iconLayout->addWidget(m_thumbnailCacheMB, 2, 1);
+
+    iconLayout->addWidget(new QLabel(tr("Thumbnail disk cache:")), 3, 0);
+    m_thumbnailDiskMB = new QSpinBox;
+    m_thumbnailDiskMB->setRange(64, 16384);
+    m_thumbnailDiskMB->setSuffix(" MB");
+    m_thumbnailDiskMB->setToolTip(tr("Disk space for stored thumbnails; least recently viewed ones are pruned in the background"));
+    iconLayout->addWidget(m_thumbnailDiskMB, 3, 1);
     
     // File display
     auto *fileGroup = new QGroupBox(tr("File Display"));
@@ -225,6 +241,8 @@ void SettingsDialog::loadSettings() {
     m_iconSize->setValue(iconSize);
     m_iconSizeSlider->setValue(iconSize);
     m_showThumbnails->setChecked(settings.value("view/showThumbnails", true).toBool());
+    m_thumbnailCacheMB->setValue(settings.value("view/thumbnailCacheMB", ThumbCache::DefaultCapacityMB).toInt());
+    m_thumbnailDiskMB->setValue(settings.value("view/thumbnailDiskMB", ThumbnailMaintenance::DefaultDiskBudgetMB).toInt());
     m_showFileExtensions->setChecked(settings.value("view/showFileExtensions", true).toBool());
     m_millerColumns->setValue(settings.value("view/millerColumnWidth", 200).toInt());
     
@@ -248,6 +266,8 @@ void SettingsDialog::saveSettings() {
     // View settings
     settings.setValue("view/iconSize", m_iconSize->value());
     settings.setValue("view/showThumbnails", m_showThumbnails->isChecked());
+    settings.setValue("view/thumbnailCacheMB", m_thumbnailCacheMB->value());
+    settings.setValue("view/thumbnailDiskMB", m_thumbnailDiskMB->value());
     settings.setValue("view/showFileExtensions", m_showFileExtensions->isChecked());
     settings.setValue("view/millerColumnWidth", m_millerColumns->value());
     
@@ -273,6 +293,8 @@ void SettingsDialog::resetToDefaults() {
     m_iconSize->setValue(64);
     m_iconSizeSlider->setValue(64);
     m_showThumbnails->setChecked(true);
+    m_thumbnailCacheMB->setValue(ThumbCache::DefaultCapacityMB);
+    m_thumbnailDiskMB->setValue(ThumbnailMaintenance::DefaultDiskBudgetMB);
     m_showFileExtensions->setChecked(true);
     m_millerColumns->setValue(200);
     
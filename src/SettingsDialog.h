@@ -40,6 +40,8 @@ private:
     QSpinBox *m_iconSize;
     QSlider *m_iconSizeSlider;
     QCheckBox *m_showThumbnails;
+    QSpinBox *m_thumbnailCacheMB;
+    QSpinBox *m_thumbnailDiskMB;
     QCheckBox *m_showFileExtensions;
     QSpinBox *m_millerColumns;
     
@@ -1,15 +1,228 @@
 #include "ThumbCache.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QImageWriter>
+#include <QPointer>
+#include <QSettings>
+
+namespace {
+
+// Share of the hot budget the protected segment may hold before demoting.
+constexpr int ProtectedPercent = 80;
+// Share of the total budget given to decoded pixmaps.
+constexpr int HotPercent = 25;
+
+}
 
 ThumbCache::ThumbCache(QObject *parent) : QObject(parent) {}
 
-bool ThumbCache::has(const QUrl &url) const {
-    return cache.contains(url.toString());
+ThumbCache *ThumbCache::instance() {
+    static QPointer<ThumbCache> shared;
+    if (!shared) {
+        shared = new ThumbCache(QCoreApplication::instance());
+        const qint64 mb = QSettings().value("view/thumbnailCacheMB", DefaultCapacityMB).toLongLong();
+        shared->setCapacity(mb * 1024 * 1024);
+    }
+    return shared;
+}
+
+QByteArray ThumbCache::encode(const QImage &image) {
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    // JPEG for opaque thumbnails; PNG at low compression keeps alpha and stays fast.
+    const bool alpha = image.hasAlphaChannel();
+    QImageWriter writer(&buffer, alpha ? "png" : "jpeg");
+    writer.setQuality(alpha ? 80 : 90);
+    if (!writer.write(image)) return QByteArray();
+    return bytes;
+}
+
+QString ThumbCache::keyFor(const QUrl &url, int size) {
+    return QString::number(size) + QLatin1Char(':') + url.toString();
+}
+
+bool ThumbCache::has(const QUrl &url, int size) const {
+    const QString key = keyFor(url, size);
+    return m_index.contains(key) || m_coldIndex.contains(key);
+}
+
+QPixmap ThumbCache::get(const QUrl &url, int size) {
+    const QString key = keyFor(url, size);
+    auto slot = m_index.find(key);
+    if (slot != m_index.end()) {
+        ++m_hits;
+        promote(*slot);
+        touchCold(key);
+        return slot->it->pixmap;
+    }
+
+    const auto cold = m_coldIndex.constFind(key);
+    if (cold != m_coldIndex.cend()) {
+        QPixmap pix;
+        if (pix.loadFromData(cold.value()->data)) {
+            ++m_coldHits;
+            touchCold(key);
+            insertHot(key, pix);
+            return pix;
+        }
+    }
+    ++m_misses;
+    return QPixmap();
+}
+
+QPixmap ThumbCache::find(const QUrl &url, int size) const {
+    const auto slot = m_index.constFind(keyFor(url, size));
+    return slot != m_index.cend() ? slot->it->pixmap : QPixmap();
+}
+
+void ThumbCache::put(const QUrl &url, int size, const QPixmap &pix) {
+    put(url, size, pix, pix.isNull() ? QByteArray() : encode(pix.toImage()));
+}
+
+void ThumbCache::put(const QUrl &url, int size, const QPixmap &pix, const QByteArray &encoded) {
+    const QString key = keyFor(url, size);
+    removeKey(key);
+    if (pix.isNull()) return;
+    insertHot(key, pix);
+    if (!encoded.isEmpty()) insertCold(key, encoded);
+}
+
+void ThumbCache::putEncoded(const QUrl &url, int size, const QByteArray &encoded) {
+    const QString key = keyFor(url, size);
+    if (m_index.contains(key)) return;  // already decoded, and its bytes are cached
+    removeKey(key);
+    if (!encoded.isEmpty()) insertCold(key, encoded);
+}
+
+void ThumbCache::remove(const QUrl &url, int size) {
+    removeKey(keyFor(url, size));
+}
+
+void ThumbCache::removeKey(const QString &key) {
+    removeHot(key);
+    const auto cold = m_coldIndex.constFind(key);
+    if (cold == m_coldIndex.cend()) return;
+    m_coldBytes -= cold.value()->data.size();
+    m_cold.erase(cold.value());
+    m_coldIndex.erase(cold);
+}
+
+void ThumbCache::clear() {
+    m_index.clear();
+    m_probation.clear();
+    m_protected.clear();
+    m_probationBytes = 0;
+    m_protectedBytes = 0;
+    m_coldIndex.clear();
+    m_cold.clear();
+    m_coldBytes = 0;
+}
+
+void ThumbCache::setCapacity(qint64 bytes) {
+    bytes = qMax<qint64>(0, bytes);
+    m_capacity = bytes * HotPercent / 100;
+    m_coldCapacity = bytes - m_capacity;
+    trim();
+    trimCold();
+}
+
+ThumbCache::Stats ThumbCache::stats() const {
+    Stats s;
+    s.hits = m_hits;
+    s.coldHits = m_coldHits;
+    s.misses = m_misses;
+    s.evictions = m_evictions;
+    s.coldEvictions = m_coldEvictions;
+    s.bytes = m_probationBytes + m_protectedBytes;
+    s.capacity = m_capacity;
+    s.coldBytes = m_coldBytes;
+    s.coldCapacity = m_coldCapacity;
+    s.count = m_index.size();
+    s.coldCount = m_coldIndex.size();
+    return s;
+}
+
+qint64 ThumbCache::costOf(const QPixmap &pix) {
+    return qint64(pix.width()) * pix.height() * qMax(1, pix.depth()) / 8;
+}
+
+void ThumbCache::insertHot(const QString &key, const QPixmap &pix) {
+    const qint64 cost = costOf(pix);
+    // Anything larger than the whole budget would only flush everything else.
+    if (cost > m_capacity) return;
+    m_probation.push_front({key, pix, cost});
+    m_probationBytes += cost;
+    m_index.insert(key, {m_probation.begin(), false});
+    trim();
+}
+
+void ThumbCache::removeHot(const QString &key) {
+    const auto slot = m_index.constFind(key);
+    if (slot == m_index.cend()) return;
+    if (slot->hot) {
+        m_protectedBytes -= slot->it->cost;
+        m_protected.erase(slot->it);
+    } else {
+        m_probationBytes -= slot->it->cost;
+        m_probation.erase(slot->it);
+    }
+    m_index.erase(slot);
+}
+
+void ThumbCache::promote(Slot &slot) {
+    if (slot.hot) {
+        m_protected.splice(m_protected.begin(), m_protected, slot.it);
+        return;
+    }
+    m_protected.splice(m_protected.begin(), m_probation, slot.it);
+    m_probationBytes -= slot.it->cost;
+    m_protectedBytes += slot.it->cost;
+    slot.hot = true;
+
+    // Protected overflow goes back to probation rather than out of the cache.
+    const qint64 protectedCap = m_capacity / 100 * ProtectedPercent;
+    while (m_protectedBytes > protectedCap && m_protected.size() > 1) {
+        auto coldest = std::prev(m_protected.end());
+        m_protectedBytes -= coldest->cost;
+        m_probationBytes += coldest->cost;
+        m_probation.splice(m_probation.begin(), m_protected, coldest);
+        m_index[coldest->key].hot = false;
+    }
+}
+
+void ThumbCache::trim() {
+    // Pixmaps dropped here usually survive as bytes in the cold tier.
+    while (m_probationBytes + m_protectedBytes > m_capacity) {
+        const bool fromProbation = !m_probation.empty();
+        Segment &segment = fromProbation ? m_probation : m_protected;
+        const Entry &victim = segment.back();
+        (fromProbation ? m_probationBytes : m_protectedBytes) -= victim.cost;
+        m_index.remove(victim.key);
+        segment.pop_back();
+        ++m_evictions;
+    }
+}
+
+void ThumbCache::insertCold(const QString &key, const QByteArray &data) {
+    if (data.size() > m_coldCapacity) return;
+    m_cold.push_front({key, data});
+    m_coldIndex.insert(key, m_cold.begin());
+    m_coldBytes += data.size();
+    trimCold();
 }
 
-QPixmap ThumbCache::get(const QUrl &url) const {
-    return cache.value(url.toString());
+void ThumbCache::touchCold(const QString &key) {
+    const auto cold = m_coldIndex.constFind(key);
+    if (cold != m_coldIndex.cend()) m_cold.splice(m_cold.begin(), m_cold, cold.value());
 }
 
-void ThumbCache::put(const QUrl &url, const QPixmap &pix) {
-    cache.insert(url.toString(), pix);
+void ThumbCache::trimCold() {
+    while (m_coldBytes > m_coldCapacity && !m_cold.empty()) {
+        const ColdEntry &victim = m_cold.back();
+        m_coldBytes -= victim.data.size();
+        m_coldIndex.remove(victim.key);
+        m_cold.pop_back();
+        ++m_coldEvictions;
+    }
 }
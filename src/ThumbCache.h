@@ -1,17 +1,117 @@
 #pragma once
 #include <QObject>
+#include <QByteArray>
 #include <QHash>
+#include <QImage>
 #include <QPixmap>
 #include <QUrl>
 
+#include <list>
+
+// Process-wide in-memory thumbnail cache, shared by all panes, in two tiers:
+// - hot: decoded pixmaps for what is on screen, evicted with a segmented
+//   LRU (new entries sit in probation and move to a protected segment on
+//   their second hit, so one pass over a big photo folder cannot flush
+//   the thumbnails of folders the user keeps coming back to);
+// - cold: the same thumbnails as compact JPEG/PNG bytes in a plain LRU,
+//   decoded back into the hot tier on demand. About ten times as many
+//   thumbnails fit per byte.
+// A quarter of the configured budget goes to the hot tier. Entries are
+// keyed by url and size (Thumbnailer level), so mip levels age separately.
 class ThumbCache : public QObject {
     Q_OBJECT
 public:
+    struct Stats {
+        quint64 hits = 0;       // served decoded from the hot tier
+        quint64 coldHits = 0;   // decoded from the cold tier
+        quint64 misses = 0;
+        quint64 evictions = 0;  // dropped from the hot tier
+        quint64 coldEvictions = 0;
+        qint64 bytes = 0;       // hot tier
+        qint64 capacity = 0;
+        qint64 coldBytes = 0;
+        qint64 coldCapacity = 0;
+        int count = 0;
+        int coldCount = 0;
+
+        quint64 lookups() const { return hits + coldHits + misses; }
+        // Share of lookups each tier answered, 0..1.
+        double hitRate() const { return lookups() ? double(hits) / lookups() : 0.0; }
+        double coldHitRate() const { return lookups() ? double(coldHits) / lookups() : 0.0; }
+    };
+
+    static constexpr int DefaultCapacityMB = 128;
+
     explicit ThumbCache(QObject *parent=nullptr);
-    bool has(const QUrl &url) const;
-    QPixmap get(const QUrl &url) const;
-    void put(const QUrl &url, const QPixmap &pix);
+    // Shared instance, sized from view/thumbnailCacheMB.
+    static ThumbCache *instance();
+
+    // Cold-tier encoding of a thumbnail; thread-safe, so workers can pay for it.
+    static QByteArray encode(const QImage &image);
+
+    static QString keyFor(const QUrl &url, int size);
+
+    // Peek without counting a hit or touching recency.
+    bool has(const QUrl &url, int size) const;
+    QPixmap get(const QUrl &url, int size);
+    // Decoded pixmap if the hot tier holds one; no stats, no recency. Lets
+    // views paint another level while the wanted one is made.
+    QPixmap find(const QUrl &url, int size) const;
+    void put(const QUrl &url, int size, const QPixmap &pix);
+    // As put(), with the cold-tier bytes already encoded.
+    void put(const QUrl &url, int size, const QPixmap &pix, const QByteArray &encoded);
+    // Cold tier only, for thumbnails made ahead of being shown.
+    void putEncoded(const QUrl &url, int size, const QByteArray &encoded);
+    void remove(const QUrl &url, int size);
+    void clear();
+
+    // Total budget for both tiers.
+    void setCapacity(qint64 bytes);
+    qint64 capacity() const { return m_capacity + m_coldCapacity; }
+    Stats stats() const;
 
 private:
-    QHash<QString, QPixmap> cache;
+    struct Entry {
+        QString key;
+        QPixmap pixmap;
+        qint64 cost = 0;
+    };
+    using Segment = std::list<Entry>;  // front is most recently used
+    struct Slot {
+        Segment::iterator it;
+        bool hot = false;  // in the protected segment
+    };
+    struct ColdEntry {
+        QString key;
+        QByteArray data;
+    };
+    using ColdList = std::list<ColdEntry>;  // front is most recently used
+
+    static qint64 costOf(const QPixmap &pix);
+    void insertHot(const QString &key, const QPixmap &pix);
+    void removeHot(const QString &key);
+    void removeKey(const QString &key);
+    void promote(Slot &slot);
+    void trim();
+    void insertCold(const QString &key, const QByteArray &data);
+    void touchCold(const QString &key);
+    void trimCold();
+
+    Segment m_probation;
+    Segment m_protected;
+    QHash<QString, Slot> m_index;
+    qint64 m_probationBytes = 0;
+    qint64 m_protectedBytes = 0;
+    qint64 m_capacity = qint64(DefaultCapacityMB) * 1024 * 1024 / 4;
+
+    ColdList m_cold;
+    QHash<QString, ColdList::iterator> m_coldIndex;
+    qint64 m_coldBytes = 0;
+    qint64 m_coldCapacity = qint64(DefaultCapacityMB) * 1024 * 1024 - m_capacity;
+
+    quint64 m_hits = 0;
+    quint64 m_coldHits = 0;
+    quint64 m_misses = 0;
+    quint64 m_evictions = 0;
+    quint64 m_coldEvictions = 0;
 };
@@ -0,0 +1,435 @@
+#include "ThumbStore.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char FileMagic[8] = {'K', 'M', 'T', 'H', 'U', 'M', 'B', '2'};
+constexpr qint64 FileHeaderSize = sizeof(FileMagic);
+constexpr quint32 RecordMagic = 0x52544d4b;  // "KMTR"
+
+// Compact on open once dead records outweigh live ones and are worth it.
+constexpr qint64 CompactMinWaste = 16ll * 1024 * 1024;
+
+struct RecordHeader {
+    quint32 magic = RecordMagic;
+    quint32 keyLength = 0;
+    quint32 dataLength = 0;  // 0 marks a removal
+    quint32 format = 0;      // QImage::Format
+    quint16 width = 0;
+    quint16 height = 0;
+    quint32 bytesPerLine = 0;
+    qint64 sourceMTime = 0;  // ms since epoch
+    qint64 sourceSize = 0;
+    quint64 checksum = 0;    // FNV-1a over key and pixels
+};
+
+qint64 align8(qint64 value) {
+    return (value + 7) & ~qint64(7);
+}
+
+quint64 fnv1a(const uchar *data, qint64 length, quint64 hash = 14695981039346656037ull) {
+    for (qint64 i = 0; i < length; ++i) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+QByteArray buildRecord(const QString &key, const QFileInfo *source, const QImage *image) {
+    const QByteArray keyBytes = key.toUtf8();
+    RecordHeader header;
+    header.keyLength = keyBytes.size();
+    if (image) {
+        header.dataLength = image->sizeInBytes();
+        header.format = image->format();
+        header.width = image->width();
+        header.height = image->height();
+        header.bytesPerLine = image->bytesPerLine();
+        header.sourceMTime = source->lastModified().toMSecsSinceEpoch();
+        header.sourceSize = source->size();
+    }
+    quint64 checksum = fnv1a(reinterpret_cast<const uchar*>(keyBytes.constData()), keyBytes.size());
+    if (image) checksum = fnv1a(image->constBits(), image->sizeInBytes(), checksum);
+    header.checksum = checksum;
+
+    QByteArray record(align8(sizeof(RecordHeader) + header.keyLength + header.dataLength), '\0');
+    char *out = record.data();
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), keyBytes.constData(), keyBytes.size());
+    if (image) memcpy(out + sizeof(header) + keyBytes.size(), image->constBits(), header.dataLength);
+    return record;
+}
+
+}
+
+ThumbStore::ThumbStore(const QString &directory) {
+    QDir().mkpath(directory);
+    m_path = QDir(directory).filePath(QStringLiteral("thumbs.pack"));
+    // A second KMiller process still reads the pack but leaves writing to
+    // the first; appends from two processes would interleave.
+    m_lock = std::make_unique<QLockFile>(m_path + QStringLiteral(".lock"));
+    m_lock->setStaleLockTime(0);
+    m_writable = m_lock->tryLock(0);
+    QMutexLocker locker(&m_mutex);
+    loadAccessTimes();
+    openPack();
+}
+
+ThumbStore::~ThumbStore() {
+    QMutexLocker locker(&m_mutex);
+    saveAccessTimesLocked();
+    closePack();
+}
+
+ThumbStore *ThumbStore::instance() {
+    static ThumbStore store([] {
+        QString cacheHome = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+        if (cacheHome.isEmpty()) cacheHome = QDir::homePath() + QStringLiteral("/.cache");
+        return cacheHome + QStringLiteral("/kmiller");
+    }());
+    return &store;
+}
+
+bool ThumbStore::openPack() {
+    m_file.setFileName(m_path);
+    if (!m_file.open(m_writable ? QIODevice::ReadWrite : QIODevice::ReadOnly)) return false;
+    m_size = m_file.size();
+
+    char magic[sizeof(FileMagic)] = {};
+    if (m_size < FileHeaderSize || m_file.read(magic, sizeof(magic)) != sizeof(magic)
+        || memcmp(magic, FileMagic, sizeof(magic)) != 0) {
+        // New or foreign file: start over.
+        if (!m_writable || !m_file.resize(0) || !m_file.seek(0) || m_file.write(FileMagic, sizeof(FileMagic)) != FileHeaderSize) {
+            closePack();
+            return false;
+        }
+        m_file.flush();
+        m_size = FileHeaderSize;
+    }
+    scan();
+    if (m_writable && m_size - m_liveBytes - FileHeaderSize > qMax(CompactMinWaste, m_liveBytes)) {
+        compactLocked();
+    }
+    return true;
+}
+
+void ThumbStore::closePack() {
+    if (m_map) m_file.unmap(m_map);
+    m_map = nullptr;
+    m_mapped = 0;
+    m_file.close();
+    m_index.clear();
+    m_size = 0;
+    m_liveBytes = 0;
+}
+
+void ThumbStore::scan() {
+    m_index.clear();
+    m_liveBytes = 0;
+    if (!mapUpTo(m_size)) return;
+
+    // Only headers are read here; checksums are verified when a record is
+    // loaded, so opening a large pack stays cheap.
+    qint64 pos = FileHeaderSize;
+    while (pos + qint64(sizeof(RecordHeader)) <= m_size) {
+        RecordHeader header;
+        memcpy(&header, m_map + pos, sizeof(header));
+        if (header.magic != RecordMagic) break;
+        const qint64 length = align8(sizeof(RecordHeader) + qint64(header.keyLength) + header.dataLength);
+        if (pos + length > m_size) break;
+
+        const QString key = QString::fromUtf8(reinterpret_cast<const char*>(m_map + pos + sizeof(header)), header.keyLength);
+        const auto previous = m_index.constFind(key);
+        if (previous != m_index.cend()) {
+            m_liveBytes -= previous->length;
+            m_index.erase(previous);
+        }
+        if (header.dataLength > 0) {
+            m_index.insert(key, {pos, length});
+            m_liveBytes += length;
+        }
+        pos += length;
+    }
+
+    // Anything after the last whole record is a write cut short by a crash.
+    if (pos < m_size && m_writable) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_mapped = 0;
+        m_file.resize(pos);
+    }
+    m_size = pos;
+}
+
+bool ThumbStore::mapUpTo(qint64 end) {
+    if (m_map && end <= m_mapped) return true;
+    if (m_map) m_file.unmap(m_map);
+    m_map = m_size > 0 ? m_file.map(0, m_size) : nullptr;
+    m_mapped = m_map ? m_size : 0;
+    return m_map && end <= m_mapped;
+}
+
+QString ThumbStore::recordKey(const QString &path, int size) {
+    return path + QChar(0) + QString::number(size);
+}
+
+QString ThumbStore::sourcePath(const QString &key) {
+    return key.left(key.indexOf(QChar(0)));
+}
+
+QImage ThumbStore::load(const QString &path, const QFileInfo &source, int size) {
+    const QString key = recordKey(path, size);
+    QMutexLocker locker(&m_mutex);
+    const auto slot = m_index.constFind(key);
+    if (slot == m_index.cend() || !mapUpTo(slot->offset + slot->length)) return QImage();
+
+    const uchar *record = m_map + slot->offset;
+    RecordHeader header;
+    memcpy(&header, record, sizeof(header));
+    if (header.sourceMTime != source.lastModified().toMSecsSinceEpoch() || header.sourceSize != source.size()) {
+        return QImage();
+    }
+    const uchar *pixels = record + sizeof(header) + header.keyLength;
+    const quint64 checksum = fnv1a(pixels, header.dataLength, fnv1a(record + sizeof(header), header.keyLength));
+    if (checksum != header.checksum || qint64(header.bytesPerLine) * header.height > header.dataLength) {
+        m_liveBytes -= slot->length;
+        m_index.erase(slot);
+        return QImage();
+    }
+    m_lastUsed.insert(key, QDateTime::currentSecsSinceEpoch());
+    // Copy out: the mapping moves when the pack grows.
+    return QImage(pixels, header.width, header.height, header.bytesPerLine,
+                  static_cast<QImage::Format>(header.format)).copy();
+}
+
+void ThumbStore::save(const QString &path, const QFileInfo &source, int size, const QImage &thumbnail) {
+    if (thumbnail.isNull() || thumbnail.width() > 0xffff || thumbnail.height() > 0xffff) return;
+    // Opaque thumbnails are stored at 3 bytes per pixel.
+    const QImage pixels = thumbnail.convertToFormat(thumbnail.hasAlphaChannel()
+        ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB888);
+    const QString key = recordKey(path, size);
+    const QByteArray record = buildRecord(key, &source, &pixels);
+
+    QMutexLocker locker(&m_mutex);
+    const qint64 offset = m_size;
+    if (!append(record)) return;
+    const auto previous = m_index.constFind(key);
+    if (previous != m_index.cend()) m_liveBytes -= previous->length;
+    m_index.insert(key, {offset, record.size()});
+    m_liveBytes += record.size();
+    m_lastUsed.insert(key, QDateTime::currentSecsSinceEpoch());
+
+    // Records are raw pixels, so a photo dump outgrows the budget long
+    // before the next scheduled maintenance.
+    if (m_budget > 0 && m_onOverBudget && !m_overBudgetReported && m_size > m_budget + m_budget / 4) {
+        m_overBudgetReported = true;
+        const std::function<void()> onOverBudget = m_onOverBudget;
+        locker.unlock();
+        onOverBudget();
+    }
+}
+
+void ThumbStore::setBudget(qint64 budgetBytes, std::function<void()> onOverBudget) {
+    QMutexLocker locker(&m_mutex);
+    m_budget = budgetBytes;
+    m_onOverBudget = std::move(onOverBudget);
+}
+
+void ThumbStore::remove(const QString &path, int size) {
+    const QString key = recordKey(path, size);
+    QMutexLocker locker(&m_mutex);
+    const auto slot = m_index.constFind(key);
+    if (slot == m_index.cend() || !append(buildRecord(key, nullptr, nullptr))) return;
+    m_liveBytes -= slot->length;
+    m_index.erase(slot);
+}
+
+bool ThumbStore::append(const QByteArray &record) {
+    if (!m_writable || !m_file.isOpen()) return false;
+    if (!m_file.seek(m_size) || m_file.write(record) != record.size() || !m_file.flush()) {
+        // Leave no half record behind for the next append to follow.
+        m_file.resize(m_size);
+        return false;
+    }
+    m_size += record.size();
+    return true;
+}
+
+ThumbStore::PruneResult ThumbStore::prune(qint64 budgetBytes, const std::atomic<bool> *cancelled) {
+    struct Candidate {
+        QString key;
+        Slot slot;
+        qint64 sourceMTime = 0;
+        qint64 sourceSize = 0;
+        qint64 lastUsed = 0;
+    };
+
+    PruneResult result;
+    QVector<Candidate> candidates;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_writable || !mapUpTo(m_size)) return result;
+        m_overBudgetReported = false;
+        candidates.reserve(m_index.size());
+        for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+            RecordHeader header;
+            memcpy(&header, m_map + it->offset, sizeof(header));
+            candidates.append({it.key(), it.value(), header.sourceMTime, header.sourceSize, m_lastUsed.value(it.key())});
+        }
+    }
+
+    QVector<Candidate> drop;
+    QVector<Candidate> keep;
+    qint64 keptBytes = 0;
+    for (const Candidate &c : std::as_const(candidates)) {
+        if (cancelled && *cancelled) return PruneResult();
+        const QFileInfo source(sourcePath(c.key));
+        if (!source.isFile() || source.lastModified().toMSecsSinceEpoch() != c.sourceMTime || source.size() != c.sourceSize) {
+            drop.append(c);
+            ++result.stale;
+        } else {
+            keep.append(c);
+            keptBytes += c.slot.length;
+        }
+    }
+    // Oldest use first; never-used records go in file order.
+    std::sort(keep.begin(), keep.end(), [](const Candidate &l, const Candidate &r) {
+        return l.lastUsed != r.lastUsed ? l.lastUsed < r.lastUsed : l.slot.offset < r.slot.offset;
+    });
+    for (const Candidate &c : std::as_const(keep)) {
+        if (keptBytes <= budgetBytes) break;
+        drop.append(c);
+        keptBytes -= c.slot.length;
+        ++result.evicted;
+    }
+
+    qint64 before = 0;
+    bool wasted = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        before = m_size;
+        for (const Candidate &c : std::as_const(drop)) {
+            // Skip records re-saved since the snapshot: they are new.
+            const auto slot = m_index.constFind(c.key);
+            if (slot == m_index.cend() || slot->offset != c.slot.offset) continue;
+            m_liveBytes -= slot->length;
+            m_index.erase(slot);
+            m_lastUsed.remove(c.key);
+        }
+        saveAccessTimesLocked();
+        wasted = m_size - FileHeaderSize > m_liveBytes;
+    }
+    if (wasted) compact();
+    result.reclaimedBytes = qMax<qint64>(0, before - fileSize());
+    return result;
+}
+
+bool ThumbStore::compact() {
+    QMutexLocker compacting(&m_compactMutex);
+    QVector<QPair<QString, Slot>> live;
+    qint64 end = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_writable || !m_file.isOpen()) return false;
+        end = m_size;
+        live.reserve(m_index.size());
+        for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) live.append({it.key(), it.value()});
+    }
+
+    // The copy reads through its own handle, so loads and saves go on while
+    // it runs; records below end never change.
+    QFile in(m_path);
+    QSaveFile out(m_path);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly)
+        || out.write(FileMagic, sizeof(FileMagic)) != FileHeaderSize) return false;
+    // Keep file order so the copy reads the old pack sequentially.
+    std::sort(live.begin(), live.end(), [](const auto &l, const auto &r) { return l.second.offset < r.second.offset; });
+    for (const auto &[key, slot] : std::as_const(live)) {
+        const QByteArray record = in.seek(slot.offset) ? in.read(slot.length) : QByteArray();
+        if (record.size() != slot.length || out.write(record) != slot.length) {
+            out.cancelWriting();
+            return false;
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // Records appended since the snapshot go over as they are. A copied
+    // record that was dropped in the meantime would come back, so give up
+    // and leave it to the next run.
+    for (const auto &[key, slot] : std::as_const(live)) {
+        const auto now = m_index.constFind(key);
+        if (now == m_index.cend() || (now->offset != slot.offset && now->offset < end)) {
+            out.cancelWriting();
+            return false;
+        }
+    }
+    if (m_size > end && (!mapUpTo(m_size)
+        || out.write(reinterpret_cast<const char*>(m_map + end), m_size - end) != m_size - end)) {
+        out.cancelWriting();
+        return false;
+    }
+    if (!out.commit()) return false;
+
+    closePack();
+    return openPack();
+}
+
+bool ThumbStore::compactLocked() {
+    if (!m_writable || !mapUpTo(m_size)) return false;
+
+    // QSaveFile renames over the old pack only once everything is written.
+    QSaveFile out(m_path);
+    if (!out.open(QIODevice::WriteOnly) || out.write(FileMagic, sizeof(FileMagic)) != FileHeaderSize) return false;
+    // Keep file order so the copy reads the old pack sequentially.
+    QVector<Slot> live(m_index.cbegin(), m_index.cend());
+    std::sort(live.begin(), live.end(), [](const Slot &l, const Slot &r) { return l.offset < r.offset; });
+    for (const Slot &slot : std::as_const(live)) {
+        if (out.write(reinterpret_cast<const char*>(m_map + slot.offset), slot.length) != slot.length) {
+            out.cancelWriting();
+            return false;
+        }
+    }
+    if (!out.commit()) return false;
+
+    closePack();
+    return openPack();
+}
+
+void ThumbStore::loadAccessTimes() {
+    QFile file(m_path + QStringLiteral(".access"));
+    if (!file.open(QIODevice::ReadOnly)) return;
+    QDataStream in(&file);
+    in >> m_lastUsed;
+    if (in.status() != QDataStream::Ok) m_lastUsed.clear();
+}
+
+void ThumbStore::saveAccessTimesLocked() const {
+    if (!m_writable) return;
+    QHash<QString, qint64> live;
+    for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+        const auto used = m_lastUsed.constFind(it.key());
+        if (used != m_lastUsed.cend()) live.insert(it.key(), used.value());
+    }
+    QSaveFile file(m_path + QStringLiteral(".access"));
+    if (!file.open(QIODevice::WriteOnly)) return;
+    QDataStream out(&file);
+    out << live;
+    file.commit();
+}
+
+qint64 ThumbStore::fileSize() const {
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+qint64 ThumbStore::liveBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_liveBytes;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QLockFile>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class QFileInfo;
+
+// Packed on-disk thumbnail store: one append-only file of raw pixel
+// records, memory-mapped for reads and indexed by a hash of source path
+// and level to record. A warm lookup is a hash probe and a memcpy, with no per-thumbnail
+// file open or PNG decode. Every record carries a checksum and a torn tail
+// is cut off on open, so a crash mid-write loses at most that record.
+// Thread-safe; only the first process to open the pack may write to it.
+class ThumbStore {
+public:
+    explicit ThumbStore(const QString &directory);
+    ~ThumbStore();
+    // Process-wide store in $XDG_CACHE_HOME/kmiller.
+    static ThumbStore *instance();
+
+    // Thumbnail of size (Thumbnailer level) stored for this version of the
+    // file (matched by mtime and size), or a null image.
+    QImage load(const QString &path, const QFileInfo &source, int size);
+    void save(const QString &path, const QFileInfo &source, int size, const QImage &thumbnail);
+    void remove(const QString &path, int size);
+
+    struct PruneResult {
+        int stale = 0;    // source deleted, moved or modified
+        int evicted = 0;  // least recently used, over budget
+        qint64 reclaimedBytes = 0;
+    };
+    // Drops stale records, then least recently used ones until the live
+    // records fit budgetBytes, and compacts. Stats sources and copies the
+    // pack without holding the store lock, so lookups and saves keep working
+    // meanwhile. Once cancelled is set it returns without dropping anything.
+    PruneResult prune(qint64 budgetBytes, const std::atomic<bool> *cancelled = nullptr);
+
+    // Disk budget save() watches between maintenance runs: once the pack
+    // grows a quarter past it, onOverBudget is called (on the saving
+    // thread), then not again until the next prune starts.
+    void setBudget(qint64 budgetBytes, std::function<void()> onOverBudget);
+
+    // Rewrites the pack with live records only (atomic replace). The lock is
+    // held only to snapshot the index and to swap the files.
+    bool compact();
+    qint64 fileSize() const;
+    qint64 liveBytes() const;
+
+private:
+    struct Slot {
+        qint64 offset = 0;
+        qint64 length = 0;
+    };
+
+    static QString recordKey(const QString &path, int size);
+    static QString sourcePath(const QString &key);
+
+    bool openPack();
+    void closePack();
+    void scan();
+    bool mapUpTo(qint64 end);
+    bool append(const QByteArray &record);
+    // Copies under the lock; only for opening, before anyone waits on it.
+    bool compactLocked();
+    void loadAccessTimes();
+    void saveAccessTimesLocked() const;
+
+    mutable QMutex m_mutex;
+    QMutex m_compactMutex;  // one compaction at a time; taken before m_mutex
+    QString m_path;
+    std::unique_ptr<QLockFile> m_lock;
+    QFile m_file;
+    uchar *m_map = nullptr;
+    qint64 m_mapped = 0;
+    qint64 m_size = 0;
+    qint64 m_liveBytes = 0;
+    bool m_writable = false;
+    qint64 m_budget = 0;
+    std::function<void()> m_onOverBudget;
+    bool m_overBudgetReported = false;
+    QHash<QString, Slot> m_index;
+    // Last use per record key (seconds), kept in a sidecar file rather than in
+    // the append-only pack; outlives compaction.
+    QHash<QString, qint64> m_lastUsed;
+};
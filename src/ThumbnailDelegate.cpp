@@ -0,0 +1,162 @@
+#include "ThumbnailDelegate.h"
+#include "ThumbCache.h"
+#include <QAbstractItemView>
+#include <QEvent>
+#include <QScrollBar>
+#include <QStyle>
+#include <QTimer>
+#include <QTreeView>
+#include <iterator>
+
+namespace {
+
+// Quiet period after scrolling or a model change before requesting.
+constexpr int SettleMs = 100;
+
+}
+
+ThumbnailDelegate::ThumbnailDelegate(QAbstractItemView *view, UrlResolver urlForIndex)
+    : QStyledItemDelegate(view), m_view(view), m_urlForIndex(std::move(urlForIndex)) {
+    m_settle = new QTimer(this);
+    m_settle->setSingleShot(true);
+    m_settle->setInterval(SettleMs);
+    connect(m_settle, &QTimer::timeout, this, &ThumbnailDelegate::refresh);
+
+    connect(view->verticalScrollBar(), &QScrollBar::valueChanged, this, &ThumbnailDelegate::pause);
+    connect(view->horizontalScrollBar(), &QScrollBar::valueChanged, this, &ThumbnailDelegate::pause);
+    view->viewport()->installEventFilter(this);
+    connect(Thumbnailer::instance(), &Thumbnailer::thumbnailReady, this, &ThumbnailDelegate::onThumbnailReady);
+    connect(view, &QAbstractItemView::iconSizeChanged, this, &ThumbnailDelegate::scheduleRefresh);
+
+    // Views get their model after the delegate in some places; follow it.
+    const auto watchModel = [this]() {
+        QAbstractItemModel *model = m_view->model();
+        if (!model) return;
+        connect(model, &QAbstractItemModel::modelReset, this, &ThumbnailDelegate::scheduleRefresh, Qt::UniqueConnection);
+        connect(model, &QAbstractItemModel::rowsInserted, this, &ThumbnailDelegate::scheduleRefresh, Qt::UniqueConnection);
+        connect(model, &QAbstractItemModel::rowsRemoved, this, &ThumbnailDelegate::scheduleRefresh, Qt::UniqueConnection);
+        connect(model, &QAbstractItemModel::layoutChanged, this, &ThumbnailDelegate::scheduleRefresh, Qt::UniqueConnection);
+    };
+    watchModel();
+    if (!m_view->model()) QTimer::singleShot(0, this, watchModel);
+}
+
+void ThumbnailDelegate::setThumbnailsEnabled(bool enabled) {
+    if (m_enabled == enabled) return;
+    m_enabled = enabled;
+    scheduleRefresh();
+    m_view->viewport()->update();
+}
+
+void ThumbnailDelegate::initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const {
+    QStyledItemDelegate::initStyleOption(option, index);
+    if (!m_enabled || index.column() != 0) return;
+    const QUrl url = m_urlForIndex(index);
+    if (!Thumbnailer::canThumbnail(url)) return;
+    // Paints only peek: refresh() does the counted lookup once per row, so
+    // repaints neither skew the stats nor promote every visible row.
+    ThumbCache *cache = ThumbCache::instance();
+    const Thumbnailer::Level wanted = level();
+    QPixmap thumbnail = cache->find(url, wanted);
+    // Mid-zoom: scale whatever level is decoded, larger ones first.
+    for (auto it = std::rbegin(Thumbnailer::Levels); thumbnail.isNull() && it != std::rend(Thumbnailer::Levels); ++it) {
+        if (*it != wanted) thumbnail = cache->find(url, *it);
+    }
+    if (thumbnail.isNull()) return;
+    option->icon = QIcon(thumbnail);
+    option->features |= QStyleOptionViewItem::HasDecoration;
+}
+
+bool ThumbnailDelegate::eventFilter(QObject *obj, QEvent *event) {
+    if (obj == m_view->viewport() && (event->type() == QEvent::Resize || event->type() == QEvent::Show)) {
+        scheduleRefresh();
+    }
+    return QStyledItemDelegate::eventFilter(obj, event);
+}
+
+Thumbnailer::Level ThumbnailDelegate::level() const {
+    QSize icon = m_view->iconSize();
+    if (!icon.isValid()) {
+        const int extent = m_view->style()->pixelMetric(QStyle::PM_SmallIconSize, nullptr, m_view);
+        icon = QSize(extent, extent);
+    }
+    return Thumbnailer::levelFor(qMax(icon.width(), icon.height()) * m_view->devicePixelRatioF());
+}
+
+void ThumbnailDelegate::scheduleRefresh() {
+    if (m_enabled) m_settle->start();
+}
+
+void ThumbnailDelegate::pause() {
+    // Whatever was queued is for rows that are moving off screen.
+    Thumbnailer::instance()->cancel(this);
+    m_wanted.clear();
+    scheduleRefresh();
+}
+
+void ThumbnailDelegate::refresh() {
+    Thumbnailer *thumbnailer = Thumbnailer::instance();
+    thumbnailer->cancel(this);
+    m_wanted.clear();
+    if (!m_enabled || !m_view->model() || !m_view->isVisible()) return;
+
+    const QModelIndex first = firstVisibleIndex();
+    if (!first.isValid()) return;
+    const int bottom = m_view->viewport()->rect().bottom();
+    const Thumbnailer::Level wanted = level();
+    ThumbCache *cache = ThumbCache::instance();
+    bool decoded = false;  // cold-tier thumbnails now in the hot tier
+    const auto want = [this, thumbnailer, cache, wanted, &decoded](const QModelIndex &index, Thumbnailer::Priority priority) {
+        const QUrl url = m_urlForIndex(index);
+        if (!Thumbnailer::canThumbnail(url)) return;
+        const bool shown = !cache->find(url, wanted).isNull();
+        if (!cache->get(url, wanted).isNull()) {
+            decoded = decoded || !shown;
+            return;
+        }
+        m_wanted.insert(url.toString());
+        thumbnailer->request(this, url, priority, wanted);
+    };
+
+    int visible = 0;
+    QModelIndex index = first;
+    for (; index.isValid() && m_view->visualRect(index).top() <= bottom; index = nextIndex(index)) {
+        want(index, Thumbnailer::Visible);
+        ++visible;
+    }
+    // About one page of look-ahead below, and behind.
+    for (int i = 0; index.isValid() && i < visible; ++i, index = nextIndex(index)) {
+        want(index, Thumbnailer::Nearby);
+    }
+    index = previousIndex(first);
+    for (int i = 0; index.isValid() && i < visible; ++i, index = previousIndex(index)) {
+        want(index, Thumbnailer::Nearby);
+    }
+    if (decoded) m_view->viewport()->update();
+}
+
+QModelIndex ThumbnailDelegate::firstVisibleIndex() const {
+    const QRect area = m_view->viewport()->rect();
+    // Probe a few points down the left edge; lists may start with spacing.
+    for (int y = area.top(); y <= area.bottom(); y += 4) {
+        const QModelIndex index = m_view->indexAt(QPoint(area.left() + 4, y));
+        if (index.isValid()) return index.siblingAtColumn(0);
+        if (y - area.top() > 32) break;
+    }
+    QAbstractItemModel *model = m_view->model();
+    return model->rowCount(m_view->rootIndex()) > 0 ? model->index(0, 0, m_view->rootIndex()) : QModelIndex();
+}
+
+QModelIndex ThumbnailDelegate::nextIndex(const QModelIndex &index) const {
+    if (auto *tree = qobject_cast<QTreeView*>(m_view)) return tree->indexBelow(index);
+    return index.siblingAtRow(index.row() + 1);
+}
+
+QModelIndex ThumbnailDelegate::previousIndex(const QModelIndex &index) const {
+    if (auto *tree = qobject_cast<QTreeView*>(m_view)) return tree->indexAbove(index);
+    return index.row() > 0 ? index.siblingAtRow(index.row() - 1) : QModelIndex();
+}
+
+void ThumbnailDelegate::onThumbnailReady(const QUrl &url) {
+    if (m_wanted.remove(url.toString())) m_view->viewport()->update();
+}
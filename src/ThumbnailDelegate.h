@@ -0,0 +1,50 @@
+#pragma once
+#include "Thumbnailer.h"
+
+#include <QSet>
+#include <QStyledItemDelegate>
+#include <QUrl>
+
+#include <functional>
+
+class QAbstractItemView;
+class QTimer;
+
+// Item delegate that paints thumbnails from the shared ThumbCache in place
+// of type icons, and asks Thumbnailer only for rows on screen (Visible)
+// plus about one page either side (Nearby). While the view scrolls, queued
+// requests are dropped; once it settles the new range is requested, so
+// rows that scrolled past are never decoded. The thumbnail level follows
+// the view's icon size and device pixel ratio; after a zoom the nearest
+// level already in memory is painted until the right one arrives.
+class ThumbnailDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+public:
+    using UrlResolver = std::function<QUrl(const QModelIndex &)>;
+
+    ThumbnailDelegate(QAbstractItemView *view, UrlResolver urlForIndex);
+
+    void setThumbnailsEnabled(bool enabled);
+    bool thumbnailsEnabled() const { return m_enabled; }
+    // Level matching the view's icon size in device pixels.
+    Thumbnailer::Level level() const;
+
+protected:
+    void initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const override;
+    bool eventFilter(QObject *obj, QEvent *event) override;
+
+private:
+    void scheduleRefresh();
+    void pause();
+    void refresh();
+    QModelIndex firstVisibleIndex() const;
+    QModelIndex nextIndex(const QModelIndex &index) const;
+    QModelIndex previousIndex(const QModelIndex &index) const;
+    void onThumbnailReady(const QUrl &url);
+
+    QAbstractItemView *m_view = nullptr;
+    UrlResolver m_urlForIndex;
+    QTimer *m_settle = nullptr;
+    bool m_enabled = true;
+    QSet<QString> m_wanted;  // urls requested for the current range
+};
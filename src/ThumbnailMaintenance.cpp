@@ -0,0 +1,151 @@
+#include "ThumbnailMaintenance.h"
+#include "IdleIoPriorityScope.h"
+#include "ThumbCache.h"
+#include "ThumbStore.h"
+#include "XdgThumbnailCache.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+
+constexpr int StartupDelayMs = 60 * 1000;
+constexpr int IntervalMs = 6 * 60 * 60 * 1000;
+
+qint64 configuredBudgetBytes() {
+    const qint64 budgetMB = QSettings().value("view/thumbnailDiskMB", ThumbnailMaintenance::DefaultDiskBudgetMB).toLongLong();
+    return budgetMB * 1024 * 1024;
+}
+
+// The private PNG-per-file store used before the shared thumbnail cache.
+qint64 removeLegacyStore() {
+    const QStringList roots = {
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation),
+        QDir::homePath() + QStringLiteral("/.cache"),
+    };
+    qint64 reclaimed = 0;
+    for (const QString &root : roots) {
+        QDir legacy(root + QStringLiteral("/kmiller/thumbs"));
+        if (root.isEmpty() || !legacy.exists()) continue;
+        QDirIterator it(legacy.absolutePath(), QDir::Files);
+        while (it.hasNext()) {
+            it.next();
+            reclaimed += it.fileInfo().size();
+        }
+        legacy.removeRecursively();
+    }
+    return reclaimed;
+}
+
+}
+
+ThumbnailMaintenance::ThumbnailMaintenance(QObject *parent) : QObject(parent) {
+    // Not the global pool: ~QCoreApplication waits for that one.
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::IdlePriority);
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        connect(app, &QCoreApplication::aboutToQuit, this, [this]() { m_cancelled = true; });
+    }
+}
+
+ThumbnailMaintenance::~ThumbnailMaintenance() {
+    ThumbStore::instance()->setBudget(0, {});
+    m_cancelled = true;
+    m_pool.waitForDone();
+}
+
+ThumbnailMaintenance *ThumbnailMaintenance::instance() {
+    static QPointer<ThumbnailMaintenance> shared;
+    if (!shared) shared = new ThumbnailMaintenance(QCoreApplication::instance());
+    return shared;
+}
+
+void ThumbnailMaintenance::schedule() {
+    if (m_timer) return;
+    watchStoreBudget();
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(StartupDelayMs);
+    connect(m_timer, &QTimer::timeout, this, [this]() {
+        m_timer->setInterval(IntervalMs);
+        m_timer->start();
+        runNow();
+    });
+    m_timer->start();
+}
+
+void ThumbnailMaintenance::runNow() {
+    if (m_running || m_cancelled) return;
+    m_running = true;
+    const qint64 budget = configuredBudgetBytes();
+    if (m_timer) watchStoreBudget();  // the budget may have changed in the settings
+
+    auto *watcher = new QFutureWatcher<Report>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        m_running = false;
+        const Report report = watcher->result();
+        if (report.staleRemoved || report.evicted || report.reclaimedBytes) {
+            qInfo() << "Thumbnail maintenance:" << report.staleRemoved << "stale," << report.evicted
+                    << "evicted," << report.reclaimedBytes / 1024 << "KiB reclaimed";
+        }
+        const ThumbCache::Stats memory = ThumbCache::instance()->stats();
+        if (memory.lookups()) {
+            qInfo() << "Thumbnail memory cache:" << qRound(memory.hitRate() * 100) << "% hot,"
+                    << qRound(memory.coldHitRate() * 100) << "% cold hits;" << memory.count << "decoded,"
+                    << memory.coldCount << "compressed";
+        }
+        emit finished(report);
+    });
+    watcher->setFuture(QtConcurrent::run(&m_pool, &ThumbnailMaintenance::run, budget, &m_cancelled));
+}
+
+void ThumbnailMaintenance::watchStoreBudget() {
+    ThumbStore::instance()->setBudget(configuredBudgetBytes(), [this]() {
+        QMetaObject::invokeMethod(this, &ThumbnailMaintenance::pruneStore, Qt::QueuedConnection);
+    });
+}
+
+void ThumbnailMaintenance::pruneStore() {
+    if (m_storePruneQueued || m_cancelled) return;
+    m_storePruneQueued = true;
+    // Queued behind a full run if one is going; the pool has one thread.
+    auto *watcher = new QFutureWatcher<ThumbStore::PruneResult>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        m_storePruneQueued = false;
+        const ThumbStore::PruneResult result = watcher->result();
+        if (result.stale || result.evicted) {
+            qInfo() << "Thumbnail store over budget:" << result.stale << "stale," << result.evicted
+                    << "evicted," << result.reclaimedBytes / 1024 << "KiB reclaimed";
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(&m_pool, [budget = configuredBudgetBytes(), cancelled = &m_cancelled]() {
+        const IdleIoPriorityScope idle;
+        return ThumbStore::instance()->prune(budget, cancelled);
+    }));
+}
+
+ThumbnailMaintenance::Report ThumbnailMaintenance::run(qint64 diskBudgetBytes, const std::atomic<bool> *cancelled) {
+    const IdleIoPriorityScope idle;
+    Report report;
+
+    const ThumbStore::PruneResult store = ThumbStore::instance()->prune(diskBudgetBytes, cancelled);
+    report.staleRemoved += store.stale;
+    report.evicted += store.evicted;
+    report.reclaimedBytes += store.reclaimedBytes;
+
+    const XdgThumbnailCache::PruneResult shared = XdgThumbnailCache::pruneStale(cancelled);
+    report.staleRemoved += shared.removed;
+    report.reclaimedBytes += shared.reclaimedBytes;
+
+    if (!*cancelled) report.reclaimedBytes += removeLegacyStore();
+    return report;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <QObject>
+#include <QThreadPool>
+
+#include <atomic>
+
+class QTimer;
+
+// Background housekeeping for the thumbnail caches: drops thumbnails of
+// deleted or modified files, keeps the packed store within its disk budget
+// (view/thumbnailDiskMB, least recently used first) and removes the old
+// per-file store. The packed store is also pruned on its own as soon as
+// it grows well past the budget. Runs on its own thread at idle CPU and I/O priority,
+// shortly after startup and then every few hours; quitting cancels a run
+// instead of waiting for it.
+class ThumbnailMaintenance : public QObject {
+    Q_OBJECT
+public:
+    struct Report {
+        int staleRemoved = 0;
+        int evicted = 0;
+        qint64 reclaimedBytes = 0;
+    };
+
+    static constexpr int DefaultDiskBudgetMB = 512;
+
+    explicit ThumbnailMaintenance(QObject *parent=nullptr);
+    ~ThumbnailMaintenance() override;
+    static ThumbnailMaintenance *instance();
+
+    // Starts the startup/periodic schedule; safe to call more than once.
+    void schedule();
+    void runNow();
+    bool isRunning() const { return m_running; }
+
+    // Worker side; blocking. Returns early once cancelled is set.
+    static Report run(qint64 diskBudgetBytes, const std::atomic<bool> *cancelled);
+
+signals:
+    void finished(const ThumbnailMaintenance::Report &report);
+
+private:
+    // Store-only prune, for when the pack outgrows its budget between runs.
+    void watchStoreBudget();
+    void pruneStore();
+
+    QTimer *m_timer = nullptr;
+    bool m_running = false;
+    bool m_storePruneQueued = false;
+    std::atomic<bool> m_cancelled = false;
+    QThreadPool m_pool;  // destroyed first, after the run has seen m_cancelled
+};
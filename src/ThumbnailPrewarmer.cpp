@@ -0,0 +1,204 @@
+#include "ThumbnailPrewarmer.h"
+#include "IdleIoPriorityScope.h"
+#include "MillerSortEngine.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QSettings>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int TickMs = 250;
+constexpr int StartupDelayMs = 15 * 1000;
+// Background requests kept queued in Thumbnailer at once.
+constexpr int Backlog = 4;
+// Cheap skips (already cached) handled per tick.
+constexpr int MaxRequestsPerTick = 64;
+constexpr int MaxFolderFiles = 2000;
+constexpr int StartupFolders = 3;
+constexpr int StartupFolderFiles = 500;
+constexpr int RememberedFolders = 50;
+// A visit counts half as much after this long.
+constexpr qint64 VisitHalfLifeSecs = 14 * 24 * 60 * 60;
+constexpr int SaveVisitsDelayMs = 30 * 1000;
+
+const QString VisitsKey = QStringLiteral("thumbnails/prewarmFolders");
+
+}
+
+ThumbnailPrewarmer::ThumbnailPrewarmer(QObject *parent) : QObject(parent) {
+    // Scans get an idle-priority thread of their own rather than lowering
+    // one of the global pool's, which could not be raised again.
+    m_scanPool.setMaxThreadCount(1);
+    m_scanPool.setThreadPriority(QThread::IdlePriority);
+    m_tick = new QTimer(this);
+    m_tick->setInterval(TickMs);
+    connect(m_tick, &QTimer::timeout, this, &ThumbnailPrewarmer::feed);
+    m_saveVisits = new QTimer(this);
+    m_saveVisits->setSingleShot(true);
+    m_saveVisits->setInterval(SaveVisitsDelayMs);
+    connect(m_saveVisits, &QTimer::timeout, this, &ThumbnailPrewarmer::saveVisits);
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        connect(app, &QCoreApplication::aboutToQuit, this, [this]() {
+            if (m_saveVisits->isActive()) saveVisits();
+        });
+    }
+}
+
+ThumbnailPrewarmer *ThumbnailPrewarmer::instance() {
+    static QPointer<ThumbnailPrewarmer> shared;
+    if (!shared) shared = new ThumbnailPrewarmer(QCoreApplication::instance());
+    return shared;
+}
+
+void ThumbnailPrewarmer::setEnabled(bool enabled) {
+    if (m_enabled == enabled) return;
+    m_enabled = enabled;
+    if (enabled) return;
+    ++m_generation;
+    m_current.clear();
+    m_startup.clear();
+    m_tick->stop();
+    Thumbnailer::instance()->cancel(this);
+}
+
+void ThumbnailPrewarmer::prewarm(const QUrl &dir, Thumbnailer::Level level) {
+    if (!m_enabled || !dir.isLocalFile()) return;
+    const QString path = dir.toLocalFile();
+    if (path == m_currentDir && !m_current.empty()) return;
+    m_currentDir = path;
+    ++m_generation;
+    m_current.clear();
+    // Queued work for the previous folder would only delay this one.
+    Thumbnailer::instance()->cancel(this);
+    enqueue(path, level, true);
+}
+
+void ThumbnailPrewarmer::scheduleStartup() {
+    if (m_startupScheduled) return;
+    m_startupScheduled = true;
+    QTimer::singleShot(StartupDelayMs, this, [this]() {
+        if (!m_enabled) return;
+        loadVisits();
+        const qint64 now = QDateTime::currentSecsSinceEpoch();
+        QStringList folders = m_visits.keys();
+        std::sort(folders.begin(), folders.end(), [this, now](const QString &l, const QString &r) {
+            return m_visits.value(l).scoreAt(now) > m_visits.value(r).scoreAt(now);
+        });
+        for (const QString &folder : folders.mid(0, StartupFolders)) {
+            enqueue(folder, Thumbnailer::levelFor(m_visits.value(folder).level), false);
+        }
+    });
+}
+
+QStringList ThumbnailPrewarmer::scan(const QString &dir, int limit) {
+    const IdleIoPriorityScope idle;
+    QStringList names = QDir(dir).entryList(QDir::Files | QDir::Readable);
+    // Same natural order as the views, so the pass runs top to bottom.
+    const QCollator collator = MillerSortEngine::collator();
+    std::sort(names.begin(), names.end(), collator);
+
+    QStringList files;
+    const QDir base(dir);
+    for (const QString &name : std::as_const(names)) {
+        const QString path = base.filePath(name);
+        if (!Thumbnailer::canThumbnail(QUrl::fromLocalFile(path))) continue;
+        files.append(path);
+        if (files.size() >= limit) break;
+    }
+    return files;
+}
+
+void ThumbnailPrewarmer::enqueue(const QString &dir, Thumbnailer::Level level, bool current) {
+    const quint64 generation = m_generation;
+    auto *watcher = new QFutureWatcher<QStringList>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, dir, level, current, generation]() {
+        watcher->deleteLater();
+        if (!m_enabled || (current && generation != m_generation)) return;
+        const QStringList files = watcher->result();
+        if (files.isEmpty()) return;
+        if (current) recordVisit(dir, level);
+        std::deque<Job> &jobs = current ? m_current : m_startup;
+        for (const QString &file : files) jobs.emplace_back(file, level);
+        if (!m_tick->isActive()) m_tick->start();
+    });
+    watcher->setFuture(QtConcurrent::run(&m_scanPool, &ThumbnailPrewarmer::scan, dir,
+                                         current ? MaxFolderFiles : StartupFolderFiles));
+}
+
+double ThumbnailPrewarmer::Visit::scoreAt(qint64 now) const {
+    const double age = qMax<qint64>(0, now - lastVisit);
+    return score * std::exp2(-age / VisitHalfLifeSecs);
+}
+
+void ThumbnailPrewarmer::loadVisits() {
+    if (m_visitsLoaded) return;
+    m_visitsLoaded = true;
+    const QVariantMap stored = QSettings().value(VisitsKey).toMap();
+    for (auto it = stored.cbegin(); it != stored.cend(); ++it) {
+        const QVariantMap entry = it.value().toMap();
+        Visit visit;
+        visit.score = entry.value("score").toDouble();
+        visit.level = entry.value("level", Thumbnailer::Normal).toInt();
+        visit.lastVisit = entry.value("last").toLongLong();
+        m_visits.insert(it.key(), visit);
+    }
+}
+
+void ThumbnailPrewarmer::recordVisit(const QString &dir, Thumbnailer::Level level) {
+    loadVisits();
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    Visit &visit = m_visits[dir];
+    visit.score = visit.scoreAt(now) + 1;
+    visit.level = level;
+    visit.lastVisit = now;
+    // Forget the least visited folders beyond the cap, never the one just
+    // visited: it starts lowest but is the likeliest to come back.
+    while (m_visits.size() > RememberedFolders) {
+        auto least = m_visits.end();
+        for (auto it = m_visits.begin(); it != m_visits.end(); ++it) {
+            if (it.key() == dir) continue;
+            if (least == m_visits.end() || it->scoreAt(now) < least->scoreAt(now)) least = it;
+        }
+        m_visits.erase(least);
+    }
+    if (!m_saveVisits->isActive()) m_saveVisits->start();
+}
+
+void ThumbnailPrewarmer::saveVisits() {
+    m_saveVisits->stop();
+    QVariantMap stored;
+    for (auto it = m_visits.cbegin(); it != m_visits.cend(); ++it) {
+        stored.insert(it.key(), QVariantMap{
+            {"score", it->score},
+            {"level", it->level},
+            {"last", it->lastVisit},
+        });
+    }
+    QSettings().setValue(VisitsKey, stored);
+}
+
+void ThumbnailPrewarmer::feed() {
+    Thumbnailer *thumbnailer = Thumbnailer::instance();
+    if (m_current.empty() && m_startup.empty()) {
+        m_tick->stop();
+        return;
+    }
+    // Anything the user is looking at goes first; try again next tick.
+    if (thumbnailer->hasInteractiveWork()) return;
+
+    for (int i = 0; i < MaxRequestsPerTick && thumbnailer->backgroundBacklog() < Backlog; ++i) {
+        std::deque<Job> &jobs = !m_current.empty() ? m_current : m_startup;
+        if (jobs.empty()) break;
+        const Job job = jobs.front();
+        jobs.pop_front();
+        thumbnailer->request(this, QUrl::fromLocalFile(job.first), Thumbnailer::Background, job.second);
+    }
+}
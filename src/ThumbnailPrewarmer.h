@@ -0,0 +1,68 @@
+#pragma once
+#include "Thumbnailer.h"
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QUrl>
+
+#include <deque>
+#include <utility>
+
+class QTimer;
+
+// Fills the thumbnail caches ahead of scrolling: the whole folder a pane
+// shows, and at startup the image folders visited most. Requests go to
+// Thumbnailer at Background priority in small batches, and only while no
+// visible or nearby thumbnails are waiting, so interactive work always
+// comes first. Per-folder and startup caps bound the total work.
+class ThumbnailPrewarmer : public QObject {
+    Q_OBJECT
+public:
+    explicit ThumbnailPrewarmer(QObject *parent=nullptr);
+    static ThumbnailPrewarmer *instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    // Replaces the current folder's pass with one for dir, at level.
+    // Folders with thumbnails count as visits for the startup pass.
+    void prewarm(const QUrl &dir, Thumbnailer::Level level);
+    // Starts the startup pass over the most visited folders; safe to call
+    // more than once.
+    void scheduleStartup();
+
+    // Worker side: thumbnailable files in dir, in name order, at most limit.
+    static QStringList scan(const QString &dir, int limit);
+
+private:
+    using Job = std::pair<QString, Thumbnailer::Level>;  // file path, level
+
+    // Visits decay with age, so folders stop counting once left alone and
+    // new ones can work their way into the startup pass.
+    struct Visit {
+        double score = 0;
+        int level = Thumbnailer::Normal;
+        qint64 lastVisit = 0;  // seconds since epoch
+        double scoreAt(qint64 now) const;
+    };
+
+    void enqueue(const QString &dir, Thumbnailer::Level level, bool current);
+    void loadVisits();
+    void recordVisit(const QString &dir, Thumbnailer::Level level);
+    void saveVisits();
+    void feed();
+
+    QThreadPool m_scanPool;
+    QTimer *m_tick = nullptr;
+    QTimer *m_saveVisits = nullptr;  // batches history writes
+    QHash<QString, Visit> m_visits;
+    bool m_visitsLoaded = false;
+    std::deque<Job> m_current;  // folder on screen; fed first
+    std::deque<Job> m_startup;
+    QString m_currentDir;
+    quint64 m_generation = 0;   // drops scans finished for an older folder
+    bool m_enabled = true;
+    bool m_startupScheduled = false;
+};
@@ -0,0 +1,252 @@
+#include "Thumbnailer.h"
+#include "ThumbCache.h"
+#include "ThumbStore.h"
+#include "IdleIoPriorityScope.h"
+#include "ImageDecoder.h"
+#include "XdgThumbnailCache.h"
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QPointer>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+#include <memory>
+#include <iterator>
+#include <optional>
+
+#include <poppler-qt6.h>
+
+namespace {
+
+// Threads of the idle-priority pool Background work runs on.
+constexpr int BackgroundSlots = 1;
+
+struct Generated {
+    QImage image;
+    QByteArray encoded;  // cold-tier bytes for ThumbCache
+};
+
+Generated generateEncoded(const QString &path, Thumbnailer::Level level, bool idle) {
+    // Background work runs on the idle-CPU pool; I/O is lowered per job.
+    std::optional<IdleIoPriorityScope> scope;
+    if (idle) scope.emplace();
+    Generated result;
+    result.image = Thumbnailer::generate(path, level);
+    if (!result.image.isNull()) result.encoded = ThumbCache::encode(result.image);
+    return result;
+}
+
+QImage fitInto(const QImage &image, int size) {
+    if (image.width() <= size && image.height() <= size) return image;
+    return image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+QImage renderImage(const QString &path, int size, bool *embedded) {
+    return ImageDecoder::decodeScaled(path, QSize(size, size), ImageDecoder::DefaultMaxDecodeBytes, embedded);
+}
+
+QImage renderPdf(const QString &path, int size) {
+    std::unique_ptr<Poppler::Document> doc(Poppler::Document::load(path));
+    if (!doc) return QImage();
+    doc->setRenderHint(Poppler::Document::Antialiasing);
+    doc->setRenderHint(Poppler::Document::TextAntialiasing);
+    std::unique_ptr<Poppler::Page> page(doc->page(0));
+    if (!page) return QImage();
+    // Render close to the target size instead of scaling a fixed-dpi page.
+    const QSizeF points = page->pageSizeF();
+    const qreal longest = qMax(points.width(), points.height());
+    const qreal dpi = longest > 0 ? 72.0 * size / longest : 96.0;
+    const QImage img = page->renderToImage(dpi, dpi);
+    if (img.isNull()) return QImage();
+    return fitInto(img, size);
+}
+
+}
+
+Thumbnailer::Thumbnailer(ThumbCache *cache, QObject *parent) : QObject(parent), m_cache(cache) {
+    // Leave cores for the GUI and the directory listers.
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+    m_pool.setThreadPriority(QThread::LowPriority);
+    // Prewarming gets threads of its own: lowering and restoring a shared
+    // thread's CPU priority does not work once it is SCHED_IDLE.
+    m_backgroundPool.setMaxThreadCount(BackgroundSlots);
+    m_backgroundPool.setThreadPriority(QThread::IdlePriority);
+}
+
+Thumbnailer::~Thumbnailer() {
+    m_queue.clear();
+    m_pending.clear();
+    m_pool.waitForDone();
+    m_backgroundPool.waitForDone();
+}
+
+Thumbnailer::Level Thumbnailer::levelFor(qreal devicePixels) {
+    for (Level level : Levels) {
+        if (level >= devicePixels) return level;
+    }
+    return XLarge;
+}
+
+Thumbnailer *Thumbnailer::instance() {
+    static QPointer<Thumbnailer> shared;
+    if (!shared) shared = new Thumbnailer(ThumbCache::instance(), QCoreApplication::instance());
+    return shared;
+}
+
+bool Thumbnailer::canThumbnail(const QUrl &url) {
+    if (!url.isLocalFile()) return false;
+    const QString suffix = QFileInfo(url.toLocalFile()).suffix().toLower();
+    if (suffix == QLatin1String("pdf") || ImageDecoder::isRawFile(url.toLocalFile())) return true;
+    static const QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    return !suffix.isEmpty() && formats.contains(suffix.toLatin1());
+}
+
+void Thumbnailer::request(const QObject *owner, const QUrl &url, Priority priority, Level level) {
+    if (!canThumbnail(url)) return;
+    const QString key = ThumbCache::keyFor(url, level);
+    if (m_running.contains(key)) return;
+    if (const auto failed = m_failed.constFind(url.toString()); failed != m_failed.cend()) {
+        if (QFileInfo(url.toLocalFile()).lastModified() == *failed) return;
+        m_failed.erase(failed);
+    }
+    if (m_cache && m_cache->has(url, level)) return;
+
+    if (owner && !m_owners.contains(owner)) {
+        m_owners.insert(owner);
+        connect(owner, &QObject::destroyed, this, [this, owner]() {
+            cancel(owner);
+            m_owners.remove(owner);
+        });
+    }
+
+    auto pending = m_pending.find(key);
+    if (pending == m_pending.end()) {
+        const QueueKey queueKey{priority, m_sequence++};
+        pending = m_pending.insert(key, {url, level, queueKey, {}});
+        m_queue.emplace(queueKey, key);
+    } else if (priority < pending->key.first) {
+        m_queue.erase(pending->key);
+        pending->key = {priority, m_sequence++};
+        m_queue.emplace(pending->key, key);
+    }
+    if (owner) pending->owners.insert(owner);
+    dispatch();
+}
+
+void Thumbnailer::cancel(const QObject *owner) {
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        it->owners.remove(owner);
+        if (it->owners.isEmpty()) {
+            m_queue.erase(it->key);
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+QImage Thumbnailer::generate(const QString &path, Level level) {
+    const QFileInfo fi(path);
+    if (!fi.isFile()) return QImage();
+
+    if (XdgThumbnailCache::isInsideCache(path)) return QImage();
+
+    // Our packed store first: no file open and no PNG decode.
+    ThumbStore *store = ThumbStore::instance();
+    const QImage packed = store->load(path, fi, level);
+    if (!packed.isNull()) return packed;
+
+    // A larger level of ours scales down far cheaper than a fresh decode.
+    for (Level larger : Levels) {
+        if (larger <= level) continue;
+        const QImage source = store->load(path, fi, larger);
+        if (source.isNull()) continue;
+        const QImage scaled = fitInto(source, level);
+        store->save(path, fi, level, scaled);
+        return scaled;
+    }
+
+    // Thumbnails other apps already made for this version of the file.
+    const QImage stored = XdgThumbnailCache::load(path, level);
+    if (!stored.isNull()) {
+        const QImage scaled = fitInto(stored, level);
+        store->save(path, fi, level, scaled);
+        return scaled;
+    }
+    if (XdgThumbnailCache::hasFailed(path)) return QImage();
+
+    bool embedded = false;
+    const QImage thumbnail = fi.suffix().compare("pdf", Qt::CaseInsensitive) == 0
+        ? renderPdf(path, level) : renderImage(path, level, &embedded);
+    if (thumbnail.isNull()) {
+        XdgThumbnailCache::markFailed(path);
+    } else {
+        // The spec has no bucket below Normal; Small only lives in our pack.
+        // Embedded previews stay there too: other apps read the shared cache
+        // and expect thumbnails made from the image itself.
+        if (level >= Normal && !embedded) {
+            XdgThumbnailCache::save(path, thumbnail, static_cast<XdgThumbnailCache::Bucket>(int(level)));
+        }
+        store->save(path, fi, level, thumbnail);
+    }
+    return thumbnail;
+}
+
+void Thumbnailer::dispatch() {
+    while (!m_queue.empty()) {
+        // The queue is priority-ordered: interactive work first, on m_pool.
+        const bool background = m_queue.begin()->first.first == Background;
+        if (background ? m_backgroundRunning >= BackgroundSlots
+                       : m_running.size() - m_backgroundRunning >= m_pool.maxThreadCount()) {
+            break;
+        }
+        const QString key = m_queue.begin()->second;
+        m_queue.erase(m_queue.begin());
+        const Request request = m_pending.take(key);
+        const QUrl url = request.url;
+        const Level level = request.level;
+        m_running.insert(key);
+        if (background) ++m_backgroundRunning;
+
+        auto *watcher = new QFutureWatcher<Generated>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, url, level, background]() {
+            watcher->deleteLater();
+            if (background) --m_backgroundRunning;
+            const Generated result = watcher->result();
+            finish(url, level, background, result.image, result.encoded);
+        });
+        watcher->setFuture(QtConcurrent::run(background ? &m_backgroundPool : &m_pool,
+                                             &generateEncoded, url.toLocalFile(), level, background));
+    }
+}
+
+bool Thumbnailer::hasInteractiveWork() const {
+    const bool queued = !m_queue.empty() && m_queue.begin()->first.first != Background;
+    return queued || m_running.size() > m_backgroundRunning;
+}
+
+int Thumbnailer::backgroundBacklog() const {
+    const auto first = m_queue.lower_bound({Background, 0});
+    return int(std::distance(first, m_queue.end())) + m_backgroundRunning;
+}
+
+void Thumbnailer::finish(const QUrl &url, Level level, bool background, const QImage &image,
+                         const QByteArray &encoded) {
+    m_running.remove(ThumbCache::keyFor(url, level));
+    if (image.isNull()) {
+        m_failed.insert(url.toString(), QFileInfo(url.toLocalFile()).lastModified());
+        emit thumbnailFailed(url);
+    } else if (background && !encoded.isEmpty()) {
+        // Prewarmed thumbnails wait compressed, without pushing what is on
+        // screen out of the decoded tier.
+        if (m_cache) m_cache->putEncoded(url, level, encoded);
+        emit thumbnailReady(url, QPixmap());
+    } else {
+        // QPixmap only exists on the GUI thread, so the conversion happens here.
+        const QPixmap pixmap = QPixmap::fromImage(image);
+        if (m_cache) m_cache->put(url, level, pixmap, encoded);
+        emit thumbnailReady(url, pixmap);
+    }
+    dispatch();
+}
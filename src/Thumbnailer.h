@@ -0,0 +1,94 @@
+#pragma once
+#include <QDateTime>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+#include <QUrl>
+
+#include <map>
+#include <utility>
+
+class ThumbCache;
+
+// Process-wide thumbnail generator. Requests are queued by priority and
+// decoded on a small low-priority pool (prewarming on a separate
+// idle-priority one), so icon lookups on the GUI thread
+// never wait for an image decode or a PDF render. Finished thumbnails go
+// into the shared ThumbCache and are announced through thumbnailReady().
+// Thumbnails come in a few mip levels; a view asks for the level matching
+// its icon size in device pixels, and each level is made only on demand.
+class Thumbnailer : public QObject {
+    Q_OBJECT
+public:
+    enum Priority {
+        Visible = 0,     // rows on screen
+        Nearby = 1,      // rows just outside the viewport
+        Background = 2,  // prewarming; one at a time, at idle priority
+    };
+
+    // Longest edge of a thumbnail, in device pixels.
+    enum Level {
+        Small = 64,
+        Normal = 128,
+        Large = 256,
+        XLarge = 512,
+    };
+    static constexpr Level Levels[] = {Small, Normal, Large, XLarge};
+    // Smallest level at least devicePixels wide, or the largest one.
+    static Level levelFor(qreal devicePixels);
+
+    explicit Thumbnailer(ThumbCache *cache, QObject *parent=nullptr);
+    ~Thumbnailer() override;
+    static Thumbnailer *instance();
+
+    // Cheap, name-based check usable on the GUI thread.
+    static bool canThumbnail(const QUrl &url);
+    // Queues url at level on behalf of owner unless it is cached or already
+    // running. Re-requesting a queued url only ever raises its priority.
+    void request(const QObject *owner, const QUrl &url, Priority priority = Visible, Level level = Normal);
+    // Drops owner's queued requests (e.g. its folder changed). Decodes
+    // already running still finish and land in the cache.
+    void cancel(const QObject *owner);
+
+    // Visible or Nearby requests queued or running.
+    bool hasInteractiveWork() const;
+    // Background requests queued or running.
+    int backgroundBacklog() const;
+
+    // Worker side: thumbnail image for a local file, or a null image.
+    static QImage generate(const QString &path, Level level = Normal);
+
+signals:
+    // pixmap is null for Background work, which is only cached compressed.
+    void thumbnailReady(const QUrl &url, const QPixmap &pixmap);
+    void thumbnailFailed(const QUrl &url);
+
+private:
+    using QueueKey = std::pair<int, quint64>;  // priority, then arrival
+    struct Request {
+        QUrl url;
+        Level level = Normal;
+        QueueKey key;
+        QSet<const QObject*> owners;
+    };
+
+    void dispatch();
+    void finish(const QUrl &url, Level level, bool background, const QImage &image, const QByteArray &encoded);
+
+    ThumbCache *m_cache = nullptr;
+    QThreadPool m_pool;
+    QThreadPool m_backgroundPool;  // idle CPU priority, Background only
+    // Queue, pending and running are keyed by ThumbCache::keyFor(url, level).
+    std::map<QueueKey, QString> m_queue;
+    QHash<QString, Request> m_pending;
+    QSet<QString> m_running;
+    // Urls that produced no thumbnail, with the mtime they had then; a file
+    // that changes since (still being written, replaced) gets another try.
+    QHash<QString, QDateTime> m_failed;
+    QSet<const QObject*> m_owners;
+    int m_backgroundRunning = 0;
+    quint64 m_sequence = 0;
+};
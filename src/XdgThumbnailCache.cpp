@@ -0,0 +1,157 @@
+#include "XdgThumbnailCache.h"
+#include "version.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+
+namespace {
+
+constexpr XdgThumbnailCache::Bucket Buckets[] = {
+    XdgThumbnailCache::Normal, XdgThumbnailCache::Large,
+    XdgThumbnailCache::XLarge, XdgThumbnailCache::XXLarge,
+};
+
+QString bucketDir(XdgThumbnailCache::Bucket bucket) {
+    switch (bucket) {
+    case XdgThumbnailCache::Large: return QStringLiteral("large");
+    case XdgThumbnailCache::XLarge: return QStringLiteral("x-large");
+    case XdgThumbnailCache::XXLarge: return QStringLiteral("xx-large");
+    case XdgThumbnailCache::Normal: break;
+    }
+    return QStringLiteral("normal");
+}
+
+QString failDir() {
+    return XdgThumbnailCache::cacheRoot() + QStringLiteral("/fail/kmiller-" KMILLER_VERSION_STR);
+}
+
+QString hashedName(const QString &uri) {
+    return QString::fromLatin1(QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Md5).toHex())
+        + QStringLiteral(".png");
+}
+
+// Spec: cache directories are private to the user.
+bool ensurePrivateDir(const QString &path) {
+    if (QFileInfo::exists(path)) return true;
+    if (!QDir().mkpath(path)) return false;
+    QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    return true;
+}
+
+// Writes atomically (temp file + rename), so readers never see half a PNG.
+bool writeEntry(const QString &dirPath, const QString &target, QImage image,
+                const QString &uri, const QFileInfo &source) {
+    if (!ensurePrivateDir(dirPath)) return false;
+    image.setText(QStringLiteral("Thumb::URI"), uri);
+    image.setText(QStringLiteral("Thumb::MTime"), QString::number(source.lastModified().toSecsSinceEpoch()));
+    image.setText(QStringLiteral("Thumb::Size"), QString::number(source.size()));
+    image.setText(QStringLiteral("Software"), QStringLiteral("KMiller " KMILLER_VERSION_STR));
+
+    QSaveFile file(target);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    QImageWriter writer(&file, "png");
+    if (!writer.write(image)) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) return false;
+    QFile::setPermissions(target, QFile::ReadOwner | QFile::WriteOwner);
+    return true;
+}
+
+// Reads entry if it describes the current version of the file. An empty
+// QImage means "no valid entry"; wantPixels=false skips the decode.
+bool readEntry(const QString &entryPath, const QString &uri, const QFileInfo &source,
+               QImage *image, bool wantPixels) {
+    QImageReader reader(entryPath, "png");
+    if (!reader.canRead()) return false;
+    if (reader.text(QStringLiteral("Thumb::URI")) != uri) return false;
+    bool ok = false;
+    const qint64 mtime = reader.text(QStringLiteral("Thumb::MTime")).toLongLong(&ok);
+    if (!ok || mtime != source.lastModified().toSecsSinceEpoch()) return false;
+    if (!wantPixels) return true;
+    return reader.read(image) && !image->isNull();
+}
+
+}
+
+QString XdgThumbnailCache::cacheRoot() {
+    QString cacheHome = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (cacheHome.isEmpty()) cacheHome = QDir::homePath() + QStringLiteral("/.cache");
+    return cacheHome + QStringLiteral("/thumbnails");
+}
+
+QString XdgThumbnailCache::fileUri(const QString &path) {
+    return QUrl::fromLocalFile(QFileInfo(path).absoluteFilePath()).toString(QUrl::FullyEncoded);
+}
+
+QString XdgThumbnailCache::thumbnailPath(const QString &path, Bucket bucket) {
+    return cacheRoot() + QLatin1Char('/') + bucketDir(bucket) + QLatin1Char('/') + hashedName(fileUri(path));
+}
+
+bool XdgThumbnailCache::isInsideCache(const QString &path) {
+    // Thumbnailing the thumbnails would only feed the cache with itself.
+    return QFileInfo(path).absoluteFilePath().startsWith(cacheRoot() + QLatin1Char('/'));
+}
+
+QImage XdgThumbnailCache::load(const QString &path, int size) {
+    const QFileInfo source(path);
+    const QString uri = fileUri(path);
+    const QString name = hashedName(uri);
+    for (Bucket bucket : Buckets) {
+        if (bucket < size) continue;
+        QImage image;
+        const QString entry = cacheRoot() + QLatin1Char('/') + bucketDir(bucket) + QLatin1Char('/') + name;
+        if (readEntry(entry, uri, source, &image, true)) return image;
+    }
+    return QImage();
+}
+
+bool XdgThumbnailCache::save(const QString &path, const QImage &thumbnail, Bucket bucket) {
+    if (thumbnail.isNull()) return false;
+    const QString dirPath = cacheRoot() + QLatin1Char('/') + bucketDir(bucket);
+    const QString uri = fileUri(path);
+    return writeEntry(dirPath, dirPath + QLatin1Char('/') + hashedName(uri), thumbnail, uri, QFileInfo(path));
+}
+
+bool XdgThumbnailCache::hasFailed(const QString &path) {
+    const QString uri = fileUri(path);
+    return readEntry(failDir() + QLatin1Char('/') + hashedName(uri), uri, QFileInfo(path), nullptr, false);
+}
+
+void XdgThumbnailCache::markFailed(const QString &path) {
+    // The spec's fail marker is a 1x1 PNG carrying just the metadata.
+    QImage marker(1, 1, QImage::Format_ARGB32);
+    marker.fill(Qt::transparent);
+    const QString uri = fileUri(path);
+    writeEntry(failDir(), failDir() + QLatin1Char('/') + hashedName(uri), marker, uri, QFileInfo(path));
+}
+
+XdgThumbnailCache::PruneResult XdgThumbnailCache::pruneStale(const std::atomic<bool> *cancelled) {
+    PruneResult result;
+    QDirIterator it(cacheRoot(), {QStringLiteral("*.png")}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext() && !(cancelled && *cancelled)) {
+        const QString entry = it.next();
+        QImageReader reader(entry, "png");
+        const QUrl uri(reader.text(QStringLiteral("Thumb::URI")));
+        if (!uri.isLocalFile()) continue;
+        const QFileInfo source(uri.toLocalFile());
+        bool ok = false;
+        const qint64 mtime = reader.text(QStringLiteral("Thumb::MTime")).toLongLong(&ok);
+        if (source.exists() && ok && mtime == source.lastModified().toSecsSinceEpoch()) continue;
+
+        const qint64 size = it.fileInfo().size();
+        if (QFile::remove(entry)) {
+            ++result.removed;
+            result.reclaimedBytes += size;
+        }
+    }
+    return result;
+}
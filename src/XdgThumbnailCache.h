@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QImage>
+#include <QString>
+
+#include <atomic>
+
+// Reader/writer for the freedesktop.org shared thumbnail cache
+// (~/.cache/thumbnails), so thumbnails made by Dolphin, Gwenview and
+// friends are reused and ours are reusable by them. Thread-safe; every
+// call works on files only.
+class XdgThumbnailCache {
+public:
+    // Spec bucket edge lengths; a thumbnail fits inside size x size.
+    enum Bucket {
+        Normal = 128,
+        Large = 256,
+        XLarge = 512,
+        XXLarge = 1024,
+    };
+
+    static QString cacheRoot();
+    // Canonical file:// URI the spec hashes and stores in Thumb::URI.
+    static QString fileUri(const QString &path);
+    static QString thumbnailPath(const QString &path, Bucket bucket);
+    static bool isInsideCache(const QString &path);
+
+    // Smallest valid thumbnail at least size px, from any bucket, or null.
+    // Valid means Thumb::URI and Thumb::MTime match the file.
+    static QImage load(const QString &path, int size);
+    static bool save(const QString &path, const QImage &thumbnail, Bucket bucket);
+
+    // Per-application fail entries, so files that cannot be thumbnailed
+    // are not retried until they change.
+    static bool hasFailed(const QString &path);
+    static void markFailed(const QString &path);
+
+    struct PruneResult {
+        int removed = 0;
+        qint64 reclaimedBytes = 0;
+    };
+    // Deletes entries (including fail markers) whose local source file is
+    // gone or has changed, as the spec allows any client to. Entries for
+    // non-file URIs are left alone. Stops early once cancelled is set.
+    static PruneResult pruneStale(const std::atomic<bool> *cancelled = nullptr);
+};
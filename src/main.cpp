@@ -2,16 +2,23 @@
 #include "ArchiveService.h"
 #include "FileChooserPortal.h"
 #include "FileOpsService.h"
+#include "MillerColumnModel.h"
+#include "MillerDirectoryCache.h"
 #include "OpenWithService.h"
 #include "Pane.h"
+#include "ThumbCache.h"
+#include "Thumbnailer.h"
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QFileInfo>
 #include <QGuiApplication>
+#include <QPixmap>
+#include <QTimer>
 #include <QUrl>
 
 #include <KZip>
@@ -164,6 +171,33 @@ static bool runQaUiLogic(const QString &fixturePath) {
     window.show();
     QCoreApplication::processEvents();
 
+    // Thumbnail cache stays inside its byte budgets, keeps re-used entries
+    // decoded and can still serve the ones it dropped from the cold tier.
+    ThumbCache thumbs;
+    QPixmap thumb(128, 128);
+    thumb.fill(Qt::gray);
+    const qint64 thumbBytes = qint64(thumb.width()) * thumb.height() * thumb.depth() / 8;
+    thumbs.setCapacity(thumbBytes * 16);
+    const QUrl keep = QUrl::fromLocalFile(fixture.filePath("keep.png"));
+    thumbs.put(keep, Thumbnailer::Normal, thumb);
+    thumbs.get(keep, Thumbnailer::Normal);
+    for (int i = 0; i < 16; ++i) {
+        thumbs.put(QUrl::fromLocalFile(fixture.filePath(QString("thumb-%1.png").arg(i))), Thumbnailer::Normal, thumb);
+    }
+    thumbs.get(QUrl::fromLocalFile(fixture.filePath("thumb-0.png")), Thumbnailer::Normal);
+    const ThumbCache::Stats thumbStats = thumbs.stats();
+    if (thumbStats.bytes > thumbStats.capacity || thumbStats.coldBytes > thumbStats.coldCapacity
+        || !thumbs.has(keep, Thumbnailer::Normal) || thumbStats.hits != 1 || thumbStats.evictions == 0 || thumbStats.coldHits != 1) {
+        qCritical() << "QA thumbnail cache broke its budget or evicted a re-used entry";
+        return false;
+    }
+    // Mip level follows icon size in device pixels, capped at the largest.
+    if (Thumbnailer::levelFor(64) != Thumbnailer::Small || Thumbnailer::levelFor(96) != Thumbnailer::Normal
+        || Thumbnailer::levelFor(192 * 2.0) != Thumbnailer::XLarge || Thumbnailer::levelFor(4096) != Thumbnailer::XLarge) {
+        qCritical() << "QA thumbnail level selection is wrong";
+        return false;
+    }
+
     qInfo() << "QA UI logic checks passed";
     return true;
 }
@@ -293,6 +327,50 @@ static bool runQaArchive(const QString &fixturePath) {
     return true;
 }
 
+static bool runQaMillerListing(const QString &location) {
+    const QUrl url = QUrl::fromUserInput(location, QDir::currentPath(), QUrl::AssumeLocalFile);
+    if (!url.isValid()) {
+        qCritical() << "QA Miller listing got an invalid URL:" << location;
+        return false;
+    }
+
+    MillerDirectoryCache cache;
+    MillerColumnModel model(&cache);
+    QEventLoop loop;
+    QElapsedTimer elapsed;
+    qint64 firstRowsMs = -1;
+    bool loaded = false;
+    QObject::connect(&model, &QAbstractItemModel::rowsInserted, &loop, [&]() {
+        if (firstRowsMs < 0) firstRowsMs = elapsed.elapsed();
+    });
+    QObject::connect(&model, &MillerColumnModel::directoryLoaded, &loop, [&]() {
+        loaded = true;
+        loop.quit();
+    });
+
+    elapsed.start();
+    model.setDirectory(url);
+    const qint64 setDirectoryMs = elapsed.elapsed();
+    // Listing is async for every scheme; the GUI thread must not wait on it.
+    if (setDirectoryMs > 250) {
+        qCritical() << "QA Miller listing blocked the caller for" << setDirectoryMs << "ms";
+        return false;
+    }
+
+    if (!loaded) {
+        QTimer::singleShot(30000, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    if (!loaded) {
+        qCritical() << "QA Miller listing did not complete within 30s:" << url.toDisplayString();
+        return false;
+    }
+
+    qInfo() << "QA Miller listing passed:" << url.toDisplayString() << model.rowCount() << "entries,"
+            << "first rows after" << firstRowsMs << "ms, complete after" << elapsed.elapsed() << "ms";
+    return true;
+}
+
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
     app.setApplicationName("KMiller");
@@ -353,6 +431,13 @@ int main(int argc, char *argv[]) {
     );
     parser.addOption(qaArchiveOption);
 
+    QCommandLineOption qaMillerListingOption(
+        QStringList() << "qa-miller-listing",
+        "List the given local path or KIO URL (e.g. sftp://localhost/tmp) through a Miller column model and exit.",
+        "url"
+    );
+    parser.addOption(qaMillerListingOption);
+
     parser.process(app);
 
     if (parser.isSet(appIdOption)) {
@@ -392,6 +477,10 @@ int main(int argc, char *argv[]) {
         return runQaArchive(parser.value(qaArchiveOption)) ? 0 : 1;
     }
 
+    if (parser.isSet(qaMillerListingOption)) {
+        return runQaMillerListing(parser.value(qaMillerListingOption)) ? 0 : 1;
+    }
+
     // Normal file manager mode
     QUrl initialUrl = QUrl::fromLocalFile("/");
     if (parser.isSet(pathOption)) {
@@ -87,6 +87,26 @@ dbus-run-session -- \
     exit 1
   }
 
+dbus-run-session -- \
+  xvfb-run -a \
+  env \
+    HOME="$QA_HOME" \
+    XDG_CONFIG_HOME="$QA_CONFIG" \
+    XDG_CACHE_HOME="$QA_CACHE" \
+    XDG_DATA_HOME="$QA_DATA" \
+    XDG_DATA_DIRS="${XDG_DATA_DIRS:-/usr/local/share:/usr/share}" \
+    XDG_RUNTIME_DIR="$QA_RUNTIME" \
+    QT_QPA_PLATFORM=xcb \
+    "$BIN" --qa-miller-listing "${KMILLER_QA_MILLER_URL:-$QA_DIR}" \
+  >/tmp/kmiller-qa-miller.stdout 2>/tmp/kmiller-qa-miller.stderr || {
+    echo "QA failed: Miller listing checks failed" >&2
+    echo "--- stdout ---" >&2
+    cat /tmp/kmiller-qa-miller.stdout >&2 || true
+    echo "--- stderr ---" >&2
+    cat /tmp/kmiller-qa-miller.stderr >&2 || true
+    exit 1
+  }
+
 dbus-run-session -- \
   xvfb-run -a \
   env \